@@ -1,3 +1,4 @@
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
@@ -5,6 +6,23 @@
 #include <stddef.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <math.h>
+#include <setjmp.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
 
 typedef struct ODLData ODLData;
 
@@ -12,19 +30,59 @@ typedef struct Object Object;
 
 typedef char * ODLWord;
 
-typedef float ODLNum;
+typedef double ODLNum;
 
+/* Lists are reference counted and shared between values, so copying one is
+   O(1). A list with a backing list is a view: bottom and top point into the
+   storage of the backing list, which owns the elements. Shared lists and views
+   are copied before anything mutates them. slots is how many elements the
+   block the list was allocated in has room for after its header. */
 typedef struct ODLList {
 	size_t alloc;
+	size_t slots;
+	size_t refs;
+	struct ODLList * backing;
+	ODLData * base;
 	ODLData * bottom;
 	ODLData * top;
 } ODLList;
 
-typedef Object * ODLObject;
+/* Objects are persistent hash maps, reference counted like lists. The
+   entries live in a hash array mapped trie whose nodes are shared between
+   the versions of a map, so an insert copies only the path to its key. */
+typedef struct ODLHamtNode ODLHamtNode;
+
+struct Object {
+	size_t refs;
+	size_t size;
+	ODLHamtNode * root;
+};
 
-typedef char * ODLString;
+typedef Object * ODLObject;
 
-typedef uint32_t ODLInt;
+/* Strings are reference counted like lists. A string with a backing string
+   is a slice: text points into the storage of the backing string, which owns
+   it, so lines can be handed out of a read buffer without copying them. */
+typedef struct ODLStr {
+	size_t refs;
+	struct ODLStr * backing;
+	size_t length;
+	char * text;
+	char data[];
+} ODLStr;
+
+typedef ODLStr * ODLString;
+
+typedef int64_t ODLInt;
+
+/* Arbitrary precision integer, used when ODLInt arithmetic overflows. The
+   magnitude is stored as little endian base 2^32 limbs. */
+typedef struct ODLBigInt {
+	size_t refs;
+	char negative;
+	size_t count;
+	uint32_t limbs[];
+} ODLBigInt;
 
 typedef enum ODLDataType {
 	ODL_ERROR,
@@ -36,12 +94,26 @@ typedef enum ODLDataType {
 	ODL_INT,
 	ODL_BUILTIN,
 	ODL_SYMBOL,
+	ODL_BIGINT,
+	ODL_SEQ,
 } ODLDataType;
 
+typedef struct ODLSeq ODLSeq;
+
 typedef struct ODLDictionary ODLDictionary;
 
 typedef void (*ODLBuiltin)(ODLList * stack, ODLDictionary * dictionary);
 
+/* arity is the number of arguments the evaluator evaluates and leaves on top
+   of the stack, first argument topmost, before calling the builtin. symbol is
+   the C name of call, which compiled programs call it by. */
+typedef struct ODLBuiltinDef {
+	ODLBuiltin call;
+	int arity;
+	char * symbol;
+	struct ODLBuiltinDef * next;
+} ODLBuiltinDef;
+
 typedef struct ODLData{
 	ODLDataType type;
 	union {
@@ -51,19 +123,92 @@ typedef struct ODLData{
 		ODLObject object;
 		ODLString string;
 		ODLInt integer;
-		ODLBuiltin builtin;
+		ODLBuiltinDef * builtin;
+		ODLBigInt * bigint;
+		ODLSeq * seq;
 	} value;
 } ODLData;
 
+/* A source produces the elements of a lazy sequence one at a time. next
+   returns 0 once it is exhausted. release frees the source, whether or not
+   it was exhausted. */
+typedef struct ODLSource ODLSource;
+
+/* Sources that can reach any element without producing the ones before it
+   also set remaining and at, counted from the next element next would
+   give; the others leave them NULL. */
+struct ODLSource {
+	char (*next)(ODLSource * source, ODLData * out, ODLDictionary * dictionary);
+	void (*release)(ODLSource * source);
+	size_t (*remaining)(ODLSource * source);
+	void (*at)(ODLSource * source, size_t index, ODLData * out);
+};
+
+/* Lazy sequences are chains of cells. A cell is forced the first time
+   anything looks at it, taking the next element from the source; it then
+   holds that element and a new cell for the rest, which inherits the source.
+   Each element is produced once however often the sequence is read, and cells
+   nothing refers to any more are freed as iteration moves along. A forced
+   cell without a tail is the end of the sequence. */
+struct ODLSeq {
+	size_t refs;
+	char forced;
+	ODLData head;
+	ODLSeq * tail;
+	ODLSource * source;
+};
+
+typedef struct ODLJitCode ODLJitCode;
+
+typedef struct ODLTyped ODLTyped;
+
 typedef struct ODLDefStack {
 	ODLWord name;
-	ODLList code;
+	size_t position;
+	ODLList * code;
+	size_t version;
+	size_t calls;
+	unsigned char backoff;
+	ODLJitCode * jit;
+	ODLTyped * typed;
 } ODLDefStack;
 
-typedef struct ODLDictionary {
+/* A frame waits for remaining more values to be evaluated onto the stack.
+   They are moved to the control stack's values as they arrive, after anything
+   the frame was pushed with. When none remain they are pushed back, first one
+   topmost, and resume is called. A frame pushed with nothing remaining
+   resumes as soon as the top of the stack is a value. A frame can also own
+   C state, which resume finds in the control stack's state; release frees
+   it if the frame is abandoned instead. */
+typedef struct ODLFrame {
+	ODLBuiltin resume;
+	size_t base;
+	int remaining;
+	void * state;
+	void (*release)(void * state);
+} ODLFrame;
+
+typedef struct ODLControl {
 	size_t alloc;
 	size_t count;
-	ODLDefStack * defs;
+	ODLFrame * frames;
+	ODLList values;
+	void * state;
+} ODLControl;
+
+typedef struct ODLDefTable ODLDefTable;
+
+/* lock is only taken by definers, and only once the dictionary is shared. */
+typedef struct ODLDictionary {
+	size_t count;
+	ODLDefTable * defs;
+	char shared;
+	pthread_mutex_t lock;
+	ODLControl control;
+	struct ODLDictionary * parent;
+	struct ODLWordMap * map;
+	struct ODLModule * modules;
+	ODLBuiltinDef * builtins;
 } ODLDictionary;
 
 
@@ -73,27 +218,265 @@ typedef struct ODLWordMap{
 	ODLWord * wordList;
 } ODLWordMap;
 
+/* Every list allocation is counted here. base, peak, allocations and start
+   are reset when an evaluation starts, so the limit and the allocation rate
+   apply to that evaluation alone. A limit of 0 means no limit. made counts
+   the lists made, including those whose block came from the pool, which
+   allocations leaves out. */
+typedef struct ODLMemory {
+	size_t lists;
+	size_t made;
+	size_t bytes;
+	size_t peak;
+	size_t base;
+	size_t allocations;
+	size_t limit;
+	char over;
+	struct timespec start;
+} ODLMemory;
+
+/* Steps of the evaluator and wall clock time an evaluation may take. fuel
+   and deadline, in milliseconds, are the limits, 0 meaning none, and are
+   armed when an evaluation starts. The evaluator only counts down tick,
+   calling checkBudgetODL when it reaches 0, so the limits are looked at
+   every ODL_BUDGET_INTERVAL steps at most and cost a decrement otherwise. */
+#define ODL_BUDGET_INTERVAL 4096
+
+typedef struct ODLBudget {
+	size_t fuel;
+	size_t deadline;
+	char armed;
+	size_t used;
+	size_t period;
+	size_t tick;
+	struct timespec end;
+} ODLBudget;
+
+/* The interpreter state that is not reached through a dictionary is per
+   thread, so each --serve worker runs its own interpreter. */
+__thread ODLMemory memoryODL;
+
+__thread ODLBudget budgetODL={0, 0, 0, 0, ODL_BUDGET_INTERVAL, ODL_BUDGET_INTERVAL};
+
+/* Set while the REPL is evaluating a line. Errors jump back to it, so only
+   that evaluation is abandoned; without one they exit. */
+__thread jmp_buf * recoverODL=NULL;
+
+/* Where dumps and error messages go: stdout, or the response being built
+   for a --serve request. */
+__thread FILE * outODL;
+
+/* Values only pass between threads through a dictionary shareDictionaryODL
+   has been called on. From then on reference counts change atomically, as a
+   value copied out of a definition by one thread may be let go of by
+   another; until then they are plain increments and decrements. */
+char sharedODL=0;
+
+static inline void retainODL(size_t * refs){
+	if(sharedODL){
+		__atomic_add_fetch(refs, 1, __ATOMIC_RELAXED);
+	}else{
+		(*refs)++;
+	}
+}
+
+/* Returns how many references are left. */
+static inline size_t releaseRefODL(size_t * refs){
+	if(sharedODL){
+		return __atomic_sub_fetch(refs, 1, __ATOMIC_ACQ_REL);
+	}
+	return --*refs;
+}
+
+/* What a builtin owns only through C locals while it does something that can
+   abort, such as evaluating a body or forcing a sequence, is held on a chain
+   of records in its own C frame. abortODL releases the holds made since the
+   recovery point it jumps to was set, whose floor is where the chain stood
+   then, so an abandoned evaluation frees them rather than leaking them. */
+typedef struct ODLHold {
+	void (*release)(void * p);
+	void * p;
+	struct ODLHold * next;
+} ODLHold;
+
+__thread ODLHold * holdsODL=NULL;
+__thread ODLHold * holdFloorODL=NULL;
+
+void holdODL(ODLHold * hold, void (*release)(void *), void * p){
+	hold->release=release;
+	hold->p=p;
+	hold->next=holdsODL;
+	holdsODL=hold;
+}
+
+/* Holds are let go of in the reverse of the order they were made. */
+void unholdODL(ODLHold * hold){
+	holdsODL=hold->next;
+}
+
+void releaseValueODL(void * d);
+void releaseListODL(void * list);
+
+void abortODL(){
+	while(holdsODL!=holdFloorODL){
+		ODLHold * hold=holdsODL;
+		holdsODL=hold->next;
+		hold->release(hold->p);
+	}
+	if(recoverODL){
+		longjmp(*recoverODL, 1);
+	}
+	exit(1);
+}
+
+void resetBudgetODL(){
+	size_t period=ODL_BUDGET_INTERVAL;
+	if(budgetODL.armed && budgetODL.fuel && budgetODL.fuel-budgetODL.used<period){
+		period=budgetODL.fuel-budgetODL.used;
+	}
+	budgetODL.period=period;
+	budgetODL.tick=period;
+}
+
+/* Once the budget is spent every later check fails too, so fibers and
+   builtins that catch errors to clean up can not carry on past it. */
+void checkBudgetODL(){
+	if(memoryODL.over){
+		memoryODL.over=0;
+		resetBudgetODL();
+		fprintf(outODL, "Heap limit of %zu bytes exceeded", memoryODL.limit);
+		abortODL();
+	}
+	if(!budgetODL.armed){
+		budgetODL.tick=ODL_BUDGET_INTERVAL;
+		return;
+	}
+	budgetODL.used+=budgetODL.period;
+	if(budgetODL.fuel && budgetODL.used>=budgetODL.fuel){
+		budgetODL.period=budgetODL.tick=1;
+		fprintf(outODL, "Budget exhausted after %zu steps", budgetODL.fuel);
+		abortODL();
+	}
+	if(budgetODL.deadline){
+		struct timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		if(now.tv_sec>budgetODL.end.tv_sec || (now.tv_sec==budgetODL.end.tv_sec && now.tv_nsec>=budgetODL.end.tv_nsec)){
+			budgetODL.period=budgetODL.tick=1;
+			fprintf(outODL, "Budget exhausted after %zu ms", budgetODL.deadline);
+			abortODL();
+		}
+	}
+	resetBudgetODL();
+}
+
+static inline void stepODL(){
+	if(--budgetODL.tick==0){
+		checkBudgetODL();
+	}
+}
+
+void startEvaluationODL(){
+	memoryODL.base=memoryODL.bytes;
+	memoryODL.peak=memoryODL.bytes;
+	memoryODL.allocations=0;
+	memoryODL.over=0;
+	clock_gettime(CLOCK_MONOTONIC, &memoryODL.start);
+	budgetODL.armed=budgetODL.fuel || budgetODL.deadline;
+	budgetODL.used=0;
+	budgetODL.end.tv_sec=memoryODL.start.tv_sec+budgetODL.deadline/1000;
+	budgetODL.end.tv_nsec=memoryODL.start.tv_nsec+budgetODL.deadline%1000*1000000;
+	if(budgetODL.end.tv_nsec>=1000000000){
+		budgetODL.end.tv_sec++;
+		budgetODL.end.tv_nsec-=1000000000;
+	}
+	resetBudgetODL();
+}
+
+void countBytesODL(size_t bytes){
+	memoryODL.bytes+=bytes;
+	if(memoryODL.bytes>memoryODL.peak){
+		memoryODL.peak=memoryODL.bytes;
+	}
+}
+
+void countAllocODL(size_t bytes){
+	memoryODL.allocations++;
+	countBytesODL(bytes);
+}
+
+/* Going over the limit is acted on at the next step of the evaluator, by
+   which time the builtin that asked for the storage has put what it owns
+   back on a stack, so the abort leaks nothing. One that carries on growing
+   to twice the limit without returning is stopped where it is. */
+void checkLimitODL(size_t bytes){
+	if(memoryODL.limit && memoryODL.bytes+bytes>memoryODL.base+memoryODL.limit){
+		if(memoryODL.bytes+bytes>memoryODL.base+2*memoryODL.limit){
+			memoryODL.over=0;
+			fprintf(outODL, "Heap limit of %zu bytes exceeded", memoryODL.limit);
+			abortODL();
+		}
+		memoryODL.over=1;
+		budgetODL.tick=1;
+	}
+}
+
+/* Called before growing storage, so an evaluation that goes over the limit is
+   stopped while every list is still intact. */
+void reserveODL(size_t bytes){
+	checkLimitODL(bytes);
+	countAllocODL(bytes);
+}
+
 char isNumeric(char text){
 	return (text>=48 && text<=57);
 }
 
-void pushODL(ODLList * stack, ODLData data){
-	if(stack->top-stack->alloc>=stack->bottom){
-		int count=stack->top-stack->bottom;
-		stack->alloc*=2;
-		stack->bottom=realloc(stack->bottom, stack->alloc*sizeof(ODLData));
+void growODL(ODLList * stack){
+	size_t count=stack->top-stack->bottom;
+	if(stack->bottom-stack->base>count){
+		memmove(stack->base, stack->bottom, count*sizeof(ODLData));
+	}else{
+		size_t offset=stack->bottom-stack->base;
+		if(stack->base==(ODLData *)(stack+1)){
+			/* Spilling out of the block the list was allocated with. A list
+			   that has outgrown it is likely to keep growing, so it skips a
+			   doubling. */
+			size_t alloc=stack->alloc*4;
+			reserveODL(alloc*sizeof(ODLData));
+			ODLData * heap=malloc(alloc*sizeof(ODLData));
+			memcpy(heap, stack->base, stack->alloc*sizeof(ODLData));
+			memoryODL.bytes-=stack->alloc*sizeof(ODLData);
+			stack->alloc=alloc;
+			stack->base=heap;
+		}else{
+			reserveODL(stack->alloc*sizeof(ODLData));
+			stack->alloc*=2;
+			stack->base=realloc(stack->base, stack->alloc*sizeof(ODLData));
+		}
+		stack->bottom=stack->base+offset;
 		stack->top=stack->bottom+count;
+		return;
+	}
+	stack->bottom=stack->base;
+	stack->top=stack->bottom+count;
+}
+
+void pushODL(ODLList * stack, ODLData data){
+	if(stack->top>=stack->base+stack->alloc){
+		growODL(stack);
 	}
 	*(stack->top)=data;
 	stack->top++;
 }
 
 void unshiftODL(ODLList * stack, ODLData data){
-	if(stack->top-stack->alloc>=stack->bottom){
-		int count=stack->top-stack->bottom;
-		stack->alloc*=2;
-		stack->bottom=realloc(stack->bottom, stack->alloc*sizeof(ODLData));
-		stack->top=stack->bottom+count;
+	if(stack->bottom>stack->base){
+		stack->bottom--;
+		*(stack->bottom)=data;
+		return;
+	}
+	if(stack->top>=stack->base+stack->alloc){
+		growODL(stack);
 	}
 	
 	ODLData * top=(stack->top);
@@ -106,22 +489,15 @@ void unshiftODL(ODLList * stack, ODLData data){
 }
 
 ODLData shiftODL(ODLList * stack){
-		
 	ODLData res=*(stack->bottom);
-	ODLData * cur=stack->bottom;
-	while(cur<stack->top-1){
-		*cur=*(cur+1);
-		cur++;
-	}
-	stack->top--;
-	
+	stack->bottom++;
 	return res;
 }
 
 ODLData popODL(ODLList * stack){
 	if(stack->top==stack->bottom){
-		printf("Tried to pop from an empty stack");
-		exit(1);
+		fprintf(outODL, "Tried to pop from an empty stack");
+		abortODL();
 	}
 	ODLData d=*(stack->top-1);
 	stack->top--;
@@ -140,65 +516,493 @@ void reverseODL(ODLList * stack){
 		bottom++;
 	}
 }
-void dumpODL(ODLList * stack, int indent);
+ODLBigInt * allocBigInt(size_t count){
+	ODLBigInt * big=malloc(sizeof(ODLBigInt)+count*sizeof(uint32_t));
+	big->refs=1;
+	big->negative=0;
+	big->count=count;
+	memset(big->limbs, 0, count*sizeof(uint32_t));
+	return big;
+}
 
-void dumpODLData(ODLData d, int indent){
-	
-	char tabString[indent+1];
-	int i;
-	for(i=0; i<indent; i++){
-		tabString[i]='\t';
+void trimBigInt(ODLBigInt * big){
+	while(big->count>0 && big->limbs[big->count-1]==0){
+		big->count--;
 	}
-	tabString[i]=0;
-	
-	if(d.type==ODL_WORD){
-		printf("%sWord: %s\n", tabString, d.value.word);
-		return;
+	if(big->count==0){
+		big->negative=0;
 	}
-	if(d.type==ODL_SYMBOL){
-		printf("%sSymbol: %s\n", tabString, d.value.word);
-		return;
+}
+
+ODLBigInt * bigIntFromInt(ODLInt v){
+	ODLBigInt * big=allocBigInt(2);
+	uint64_t mag=v<0 ? (uint64_t)(-(v+1))+1 : (uint64_t)v;
+	big->negative=v<0;
+	big->limbs[0]=(uint32_t)mag;
+	big->limbs[1]=(uint32_t)(mag>>32);
+	trimBigInt(big);
+	return big;
+}
+
+ODLBigInt * bigIntFromString(char * text){
+	char negative=(*text=='-');
+	if(negative){
+		text++;
+	}
+	size_t digits=strlen(text);
+	ODLBigInt * big=allocBigInt(digits/9+1);
+	big->count=0;
+	for(; *text; text++){
+		uint64_t carry=*text-'0';
+		for(size_t i=0; i<big->count; i++){
+			uint64_t cur=(uint64_t)big->limbs[i]*10+carry;
+			big->limbs[i]=(uint32_t)cur;
+			carry=cur>>32;
+		}
+		if(carry){
+			big->limbs[big->count++]=(uint32_t)carry;
+		}
+	}
+	big->negative=negative;
+	trimBigInt(big);
+	return big;
+}
+
+int compareMagnitude(ODLBigInt * a, ODLBigInt * b){
+	if(a->count!=b->count){
+		return a->count<b->count ? -1 : 1;
+	}
+	for(size_t i=a->count; i>0; i--){
+		if(a->limbs[i-1]!=b->limbs[i-1]){
+			return a->limbs[i-1]<b->limbs[i-1] ? -1 : 1;
+		}
+	}
+	return 0;
+}
+
+int bigIntCompare(ODLBigInt * a, ODLBigInt * b){
+	if(a->negative!=b->negative){
+		return a->negative ? -1 : 1;
+	}
+	int res=compareMagnitude(a, b);
+	return a->negative ? -res : res;
+}
+
+/* Adds a and b, negating b first when subtract is set. */
+ODLBigInt * bigIntAdd(ODLBigInt * a, ODLBigInt * b, char subtract){
+	char bNegative=subtract ? !b->negative : b->negative;
+	ODLBigInt * res;
+	if(a->negative==bNegative){
+		size_t count=(a->count > b->count ? a->count : b->count)+1;
+		res=allocBigInt(count);
+		uint64_t carry=0;
+		for(size_t i=0; i<count; i++){
+			uint64_t cur=carry;
+			cur+=i<a->count ? a->limbs[i] : 0;
+			cur+=i<b->count ? b->limbs[i] : 0;
+			res->limbs[i]=(uint32_t)cur;
+			carry=cur>>32;
+		}
+		res->negative=a->negative;
+	}else{
+		ODLBigInt * larger=a;
+		ODLBigInt * smaller=b;
+		res=NULL;
+		if(compareMagnitude(a, b)<0){
+			larger=b;
+			smaller=a;
+		}
+		res=allocBigInt(larger->count);
+		int64_t borrow=0;
+		for(size_t i=0; i<larger->count; i++){
+			int64_t cur=(int64_t)larger->limbs[i]-borrow-(i<smaller->count ? smaller->limbs[i] : 0);
+			borrow=cur<0;
+			res->limbs[i]=(uint32_t)(cur+(borrow ? ((int64_t)1<<32) : 0));
+		}
+		res->negative=(larger==a ? a->negative : bNegative);
+	}
+	trimBigInt(res);
+	return res;
+}
+
+ODLBigInt * bigIntMultiply(ODLBigInt * a, ODLBigInt * b){
+	ODLBigInt * res=allocBigInt(a->count+b->count);
+	for(size_t i=0; i<a->count; i++){
+		uint64_t carry=0;
+		for(size_t j=0; j<b->count; j++){
+			uint64_t cur=(uint64_t)a->limbs[i]*b->limbs[j]+res->limbs[i+j]+carry;
+			res->limbs[i+j]=(uint32_t)cur;
+			carry=cur>>32;
+		}
+		res->limbs[i+b->count]=(uint32_t)carry;
+	}
+	res->negative=a->negative!=b->negative;
+	trimBigInt(res);
+	return res;
+}
+
+ODLNum bigIntToNum(ODLBigInt * big){
+	ODLNum res=0;
+	for(size_t i=big->count; i>0; i--){
+		res=res*4294967296.0+big->limbs[i-1];
+	}
+	return big->negative ? -res : res;
+}
+
+/* Writes the decimal digits of big into a newly allocated string. */
+char * bigIntToString(ODLBigInt * big){
+	size_t count=big->count;
+	uint32_t * limbs=malloc((count+1)*sizeof(uint32_t));
+	memcpy(limbs, big->limbs, count*sizeof(uint32_t));
+	char * text=malloc(count*10+3);
+	char * end=text+count*10+2;
+	char * cur=end;
+	*cur=0;
+	do{
+		uint64_t rem=0;
+		for(size_t i=count; i>0; i--){
+			uint64_t v=(rem<<32)|limbs[i-1];
+			limbs[i-1]=(uint32_t)(v/1000000000);
+			rem=v%1000000000;
+		}
+		while(count>0 && limbs[count-1]==0){
+			count--;
+		}
+		for(int i=0; i<9 && (count>0 || rem>0 || i==0); i++){
+			*--cur='0'+rem%10;
+			rem/=10;
+		}
+	}while(count>0);
+	if(big->negative){
+		*--cur='-';
+	}
+	memmove(text, cur, end-cur+1);
+	free(limbs);
+	return text;
+}
+
+void freeBigInt(ODLBigInt * big){
+	if(releaseRefODL(&big->refs)==0){
+		free(big);
+	}
+}
+
+/* Wraps a bigint result as a value, demoting it to ODL_INT when it fits. */
+ODLData bigIntResult(ODLBigInt * big){
+	ODLData d;
+	if(big->count<=2){
+		uint64_t mag=big->count==0 ? 0 : big->limbs[0];
+		if(big->count==2){
+			mag|=(uint64_t)big->limbs[1]<<32;
+		}
+		if((!big->negative && mag<=INT64_MAX) || (big->negative && mag<=(uint64_t)INT64_MAX+1)){
+			d.type=ODL_INT;
+			d.value.integer=big->negative ? (ODLInt)(0-mag) : (ODLInt)mag;
+			freeBigInt(big);
+			return d;
+		}
+	}
+	d.type=ODL_BIGINT;
+	d.value.bigint=big;
+	return d;
+}
+
+/* Returns d as a bigint, allocating one for ODL_INT values. */
+ODLBigInt * asBigInt(ODLData * d){
+	if(d->type==ODL_BIGINT){
+		retainODL(&d->value.bigint->refs);
+		return d->value.bigint;
 	}
-	if(d.type==ODL_NUM){
-		printf("%sNum: %f\n", tabString, d.value.num);
+	return bigIntFromInt(d->value.integer);
+}
+
+ODLStr * allocString(size_t length){
+	reserveODL(sizeof(ODLStr)+length+1);
+	ODLStr * string=malloc(sizeof(ODLStr)+length+1);
+	string->refs=1;
+	string->backing=NULL;
+	string->length=length;
+	string->text=string->data;
+	string->data[length]=0;
+	return string;
+}
+
+ODLStr * sliceString(ODLStr * string, char * text, size_t length){
+	reserveODL(sizeof(ODLStr));
+	ODLStr * slice=malloc(sizeof(ODLStr));
+	slice->refs=1;
+	slice->backing=string->backing ? string->backing : string;
+	retainODL(&slice->backing->refs);
+	slice->length=length;
+	slice->text=text;
+	return slice;
+}
+
+void freeString(ODLStr * string){
+	if(releaseRefODL(&string->refs)>0){
 		return;
 	}
-	if(d.type==ODL_INT){
-		printf("%sInt: %d\n", tabString, d.value.integer);
+	if(string->backing){
+		memoryODL.bytes-=sizeof(ODLStr);
+		freeString(string->backing);
+	}else{
+		memoryODL.bytes-=sizeof(ODLStr)+string->length+1;
+	}
+	free(string);
+}
+
+void freeODL(ODLData * d);
+
+ODLSeq * allocSeq(ODLSource * source){
+	reserveODL(sizeof(ODLSeq));
+	ODLSeq * seq=malloc(sizeof(ODLSeq));
+	seq->refs=1;
+	seq->forced=0;
+	seq->tail=NULL;
+	seq->source=source;
+	return seq;
+}
+
+void forceSeq(ODLSeq * seq, ODLDictionary * dictionary){
+	if(seq->forced){
 		return;
 	}
+	/* Sources can run without going through the evaluator, as range does,
+	   so forcing a cell counts as a step. */
+	stepODL();
+	ODLSource * source=seq->source;
+	if(source->next(source, &seq->head, dictionary)){
+		seq->tail=allocSeq(source);
+	}else{
+		source->release(source);
+	}
+	seq->source=NULL;
+	seq->forced=1;
+}
+
+char seqEmpty(ODLSeq * seq, ODLDictionary * dictionary){
+	forceSeq(seq, dictionary);
+	return seq->tail==NULL;
+}
+
+/* Iterative, so dropping the last reference to a long forced chain does not
+   recurse once per cell. */
+void freeSeq(ODLSeq * seq){
+	while(seq!=NULL && releaseRefODL(&seq->refs)==0){
+		ODLSeq * tail=seq->tail;
+		if(!seq->forced){
+			seq->source->release(seq->source);
+		}else if(tail!=NULL){
+			freeODL(&seq->head);
+		}
+		memoryODL.bytes-=sizeof(ODLSeq);
+		free(seq);
+		seq=tail;
+	}
+}
+
+/* Output is built in a buffer and written in large pieces rather than
+   through a printf per line. */
+typedef struct ODLBuffer {
+	char * data;
+	size_t length;
+	size_t alloc;
+} ODLBuffer;
+
+#define ODL_DUMP_FLUSH 65536
+
+void appendODL(ODLBuffer * buffer, char * data, size_t length){
+	if(buffer->length+length>buffer->alloc){
+		buffer->alloc=buffer->alloc*2>buffer->length+length ? buffer->alloc*2 : buffer->length+length+256;
+		buffer->data=realloc(buffer->data, buffer->alloc);
+	}
+	memcpy(buffer->data+buffer->length, data, length);
+	buffer->length+=length;
+}
+
+void appendTextODL(ODLBuffer * buffer, char * text){
+	appendODL(buffer, text, strlen(text));
+}
+
+void appendTabsODL(ODLBuffer * buffer, int count){
+	for(int i=0; i<count; i++){
+		appendODL(buffer, "\t", 1);
+	}
+}
+
+void appendIntODL(ODLBuffer * buffer, int64_t v){
+	char text[24];
+	char * cur=text+sizeof(text);
+	uint64_t mag=v<0 ? (uint64_t)0-(uint64_t)v : (uint64_t)v;
+	do{
+		*--cur='0'+mag%10;
+		mag/=10;
+	}while(mag);
+	if(v<0){
+		*--cur='-';
+	}
+	appendODL(buffer, cur, text+sizeof(text)-cur);
+}
+
+void flushDumpODL(ODLBuffer * buffer){
+	fwrite(buffer->data, 1, buffer->length, outODL);
+	buffer->length=0;
+}
+
+void dumpListODL(ODLBuffer * buffer, ODLList * stack, int indent, char reverse);
+
+void dumpObjectODL(ODLBuffer * buffer, ODLObject object, int indent);
+
+void dumpValueODL(ODLBuffer * buffer, ODLData d, int indent){
+	if(buffer->length>=ODL_DUMP_FLUSH){
+		flushDumpODL(buffer);
+	}
 	if(d.type==ODL_LIST){
-		dumpODL(d.value.list, indent+1);
+		dumpListODL(buffer, d.value.list, indent+1, 0);
+		return;
+	}
+	appendTabsODL(buffer, indent);
+	if(d.type==ODL_WORD){
+		appendTextODL(buffer, "Word: ");
+		appendTextODL(buffer, d.value.word);
+	}else if(d.type==ODL_SYMBOL){
+		appendTextODL(buffer, "Symbol: ");
+		appendTextODL(buffer, d.value.word);
+	}else if(d.type==ODL_NUM){
+		char text[512];
+		appendTextODL(buffer, "Num: ");
+		appendODL(buffer, text, snprintf(text, sizeof(text), "%f", d.value.num));
+	}else if(d.type==ODL_INT){
+		appendTextODL(buffer, "Int: ");
+		appendIntODL(buffer, d.value.integer);
+	}else if(d.type==ODL_BIGINT){
+		char * text=bigIntToString(d.value.bigint);
+		appendTextODL(buffer, "Int: ");
+		appendTextODL(buffer, text);
+		free(text);
+	}else if(d.type==ODL_STRING){
+		appendTextODL(buffer, "String: ");
+		appendODL(buffer, d.value.string->text, d.value.string->length);
+	}else if(d.type==ODL_SEQ){
+		appendTextODL(buffer, "Sequence");
+	}else if(d.type==ODL_OBJECT){
+		dumpObjectODL(buffer, d.value.object, indent);
 		return;
+	}else{
+		appendTextODL(buffer, "Unknown type: ");
+		appendIntODL(buffer, d.type);
 	}
-	printf("%sUnknown type: %d\n", tabString, d.type);
+	appendODL(buffer, "\n", 1);
 }
 
-void dumpODLr(ODLList * stack, int indent, char reverse){
-	char tabString[indent+1];
-	int i;
-	for(i=0; i<indent-1; i++){
-		tabString[i]='\t';
-	}
-	tabString[i]=0;
-	printf("%sList: %ld\n", tabString, stack->top-stack->bottom);
+void dumpListODL(ODLBuffer * buffer, ODLList * stack, int indent, char reverse){
+	appendTabsODL(buffer, indent-1);
+	appendTextODL(buffer, "List: ");
+	appendIntODL(buffer, stack->top-stack->bottom);
+	appendODL(buffer, "\n", 1);
 	char dir=reverse ? -1 : 1;
 	int index=0;
 	for(ODLData * it=(reverse ? stack->top-1 : stack->bottom); reverse ? it>=stack->bottom : it!=stack->top; it+=dir){
-		printf("%d: ", index++);
-		dumpODLData(*it, indent);
+		appendIntODL(buffer, index++);
+		appendODL(buffer, ": ", 2);
+		dumpValueODL(buffer, *it, indent);
 	}
 }
 
+void dumpODLData(ODLData d, int indent){
+	ODLBuffer buffer={NULL, 0, 0};
+	dumpValueODL(&buffer, d, indent);
+	flushDumpODL(&buffer);
+	free(buffer.data);
+}
+
+void dumpODLr(ODLList * stack, int indent, char reverse){
+	ODLBuffer buffer={NULL, 0, 0};
+	dumpListODL(&buffer, stack, indent, reverse);
+	flushDumpODL(&buffer);
+	free(buffer.data);
+}
+
 void dumpODL(ODLList * stack, int indent){
 	dumpODLr(stack, indent, 0);
 }
 
-ODLList * allocList(size_t size){
-	ODLList * stack=malloc(sizeof(ODLList));
+void initList(ODLList * stack, size_t size){
 	stack->alloc=size > 8 ? size : 8;
-	stack->bottom=malloc(stack->alloc*sizeof(ODLData));
+	stack->slots=0;
+	stack->refs=1;
+	stack->backing=NULL;
+	reserveODL(stack->alloc*sizeof(ODLData));
+	stack->base=malloc(stack->alloc*sizeof(ODLData));
+	stack->bottom=stack->base;
+	stack->top=stack->bottom;
+}
+
+/* A list's first elements are stored in the same block as its header, and
+   only a list that outgrows them moves its elements to storage of their
+   own. Most lists never hold more than a few values, so blocks with room
+   for ODL_SMALL_LIST, which views are made in as well, are kept when freed
+   and handed out again, up to ODL_LIST_POOL of them per thread. Taking one
+   from the pool is not counted as an allocation. */
+#define ODL_SMALL_LIST 8
+#define ODL_LIST_POOL 4096
+
+__thread ODLList * listPoolODL=NULL;
+__thread size_t listPoolCountODL=0;
+
+/* A block for a header with room for ODL_SMALL_LIST elements after it.
+   bytes is what the caller accounts for it. */
+ODLList * smallBlockODL(size_t bytes){
+	if(listPoolODL==NULL){
+		reserveODL(bytes);
+		return malloc(sizeof(ODLList)+ODL_SMALL_LIST*sizeof(ODLData));
+	}
+	checkLimitODL(bytes);
+	countBytesODL(bytes);
+	ODLList * block=listPoolODL;
+	listPoolODL=block->backing;
+	listPoolCountODL--;
+	return block;
+}
+
+void releaseBlockODL(ODLList * block){
+	if(listPoolCountODL>=ODL_LIST_POOL){
+		free(block);
+		return;
+	}
+	block->backing=listPoolODL;
+	listPoolODL=block;
+	listPoolCountODL++;
+}
+
+void freeListPoolODL(){
+	while(listPoolODL!=NULL){
+		ODLList * block=listPoolODL;
+		listPoolODL=block->backing;
+		free(block);
+	}
+	listPoolCountODL=0;
+}
+
+ODLList * allocList(size_t size){
+	ODLList * stack;
+	if(size<=ODL_SMALL_LIST){
+		size=ODL_SMALL_LIST;
+		stack=smallBlockODL(size*sizeof(ODLData));
+	}else{
+		reserveODL(size*sizeof(ODLData));
+		stack=malloc(sizeof(ODLList)+size*sizeof(ODLData));
+	}
+	stack->alloc=size;
+	stack->slots=size;
+	stack->refs=1;
+	stack->backing=NULL;
+	stack->base=(ODLData *)(stack+1);
+	stack->bottom=stack->base;
 	stack->top=stack->bottom;
+	memoryODL.lists++;
+	memoryODL.made++;
+	memoryODL.bytes+=sizeof(ODLList);
 	return stack;
 }
 
@@ -219,12 +1023,67 @@ char * findInWordMap(ODLWord word, ODLWordMap * map){
 	return newWord;
 }
 
+char isSpace(char text){
+	return text==' ' || text=='\t' || text=='\n';
+}
+
+/* Reads the string literal starting at the quote *code points to and leaves
+   *code after the closing quote. */
+ODLData parseStringODL(char ** code){
+	char * it=*code+1;
+	size_t length=0;
+	while(*it!='"'){
+		if(*it==0 || (*it=='\\' && it[1]==0)){
+			fprintf(outODL, "Unterminated string");
+			abortODL();
+		}
+		it+=*it=='\\' ? 2 : 1;
+		length++;
+	}
+
+	ODLStr * string=allocString(length);
+	char * out=string->data;
+	for(it=*code+1; *it!='"'; it++){
+		if(*it!='\\'){
+			*out++=*it;
+			continue;
+		}
+		it++;
+		*out++=*it=='n' ? '\n' : *it=='t' ? '\t' : *it;
+	}
+	*code=it+1;
+
+	ODLData d;
+	d.type=ODL_STRING;
+	d.value.string=string;
+	return d;
+}
+
 ODLList * parseODL(char * code, ODLWordMap * map){
 	
 	ODLList * stack=allocList(1024);
+	ODLHold hold;
+	holdODL(&hold, &releaseListODL, stack);
+
+	while(1){
+		while(isSpace(*code)){
+			code++;
+		}
+		if(*code==0){
+			break;
+		}
+		if(*code=='"'){
+			pushODL(stack, parseStringODL(&code));
+			continue;
+		}
+
+		char * token=code;
+		while(*code!=0 && !isSpace(*code)){
+			code++;
+		}
+		char end=*code;
+		*code=0;
 
-	char * token=strtok(code, " \t\n");
-	while(token!=NULL){
 		char foundFloat=0;
 		ODLData d;
 		char first=1;
@@ -238,29 +1097,31 @@ ODLList * parseODL(char * code, ODLWordMap * map){
 		}
 		if(token[i]==0 && !(i==1 && token[i-1]=='-')){
 			if(foundFloat){
-				float v;
-				if(!sscanf(token, "%f", &v)){
-					printf("Float recognition failed");
-					exit(1);
+				double v;
+				if(!sscanf(token, "%lf", &v)){
+					fprintf(outODL, "Float recognition failed");
+					abortODL();
 				}
 				d.type=ODL_NUM;
 				d.value.num=v;
 			}else{
-				int v;
-				if(!sscanf(token, "%d", &v)){
-					printf("Integer recognition failed");
-					exit(1);
+				errno=0;
+				long long v=strtoll(token, NULL, 10);
+				if(errno==ERANGE){
+					d=bigIntResult(bigIntFromString(token));
+				}else{
+					d.type=ODL_INT;
+					d.value.integer=v;
 				}
-				d.type=ODL_INT;
-				d.value.integer=v;
 			}
 		}else{
 			d.type=ODL_WORD;
 			d.value.word=findInWordMap(token, map);
 		}
+		*code=end;
 		pushODL(stack, d);
-		token=strtok(NULL, " \t\n");
 	}
+	unholdODL(&hold);
 	
 	reverseODL(stack);
 
@@ -268,117 +1129,686 @@ ODLList * parseODL(char * code, ODLWordMap * map){
 }
 
 
-ODLData findInDictionary(ODLDictionary * dictionary, char * name){
-	for(int i=0; i<dictionary->count; i++){
-		if(dictionary->defs[i].name==name){
-			ODLList * list=&(dictionary->defs[i].code);
-			ODLData * entry=list->top-1;
-			return *entry;
-		}
-	}
-	printf("Could not find %s in dictionary\n", name);
-	exit(1);
+/* A dictionary that shareDictionaryODL has been called on can be read by
+   any number of threads while others define in it. Readers take no lock:
+   they pin themselves to the current epoch while they hold pointers into a
+   dictionary, and unpin when they are done. What a definer replaces is not
+   freed but retired, and only freed once the global epoch is two past the
+   one it was retired in. The epoch only moves on when every pinned thread
+   has seen it, so by then no thread can still be pinned from before the
+   block was taken out of the dictionary. */
+typedef struct ODLEpoch {
+	size_t state;
+	size_t depth;
+	char used;
+	struct ODLEpoch * next;
+} ODLEpoch;
+
+typedef struct ODLRetired {
+	struct ODLRetired * next;
+	size_t epoch;
+	void (*release)(void * block);
+	void * block;
+} ODLRetired;
+
+size_t epochODL=0;
+ODLEpoch * epochsODL=NULL;
+ODLRetired * retiredODL=NULL;
+pthread_mutex_t epochLockODL=PTHREAD_MUTEX_INITIALIZER;
+pthread_key_t epochKeyODL;
+pthread_once_t epochOnceODL=PTHREAD_ONCE_INIT;
+
+/* A thread's record, whose state is its epoch shifted up one with the low
+   bit set while it is pinned. Records are never freed, as definers walk
+   them; that of a thread that has finished is used again by the next one
+   to pin. */
+__thread ODLEpoch * threadEpochODL=NULL;
+
+void releaseEpochODL(void * epoch){
+	__atomic_store_n(&((ODLEpoch *)epoch)->used, 0, __ATOMIC_RELEASE);
 }
 
-void pushToDictionary(ODLDictionary * dictionary, ODLWord name, ODLData d){
-	for(int i=0; i<dictionary->count; i++){
-		if(dictionary->defs[i].name==name){
-			pushODL(&(dictionary->defs[i].code), d);
-			return;
-		}
+void makeEpochKeyODL(){
+	pthread_key_create(&epochKeyODL, &releaseEpochODL);
+}
+
+void registerEpochODL(){
+	pthread_once(&epochOnceODL, &makeEpochKeyODL);
+	pthread_mutex_lock(&epochLockODL);
+	ODLEpoch * epoch=epochsODL;
+	while(epoch!=NULL && __atomic_load_n(&epoch->used, __ATOMIC_ACQUIRE)){
+		epoch=epoch->next;
 	}
-	
-	if(dictionary->count>=dictionary->alloc){
-		dictionary->alloc*=2;
-		dictionary->defs=realloc(dictionary->defs, dictionary->alloc*sizeof(ODLDefStack));
+	if(epoch==NULL){
+		epoch=malloc(sizeof(ODLEpoch));
+		epoch->next=epochsODL;
+		epochsODL=epoch;
 	}
-	
-	dictionary->defs[dictionary->count].name=name;
-	
-	ODLList * newList=&(dictionary->defs[dictionary->count].code);
-	newList->alloc=8;
-	newList->bottom=malloc(newList->alloc*sizeof(ODLData));
-	newList->top=newList->bottom;
-	
-	dictionary->count++;
-	pushODL(newList, d);
+	epoch->state=0;
+	epoch->depth=0;
+	epoch->used=1;
+	pthread_mutex_unlock(&epochLockODL);
+	pthread_setspecific(epochKeyODL, epoch);
+	threadEpochODL=epoch;
 }
 
-ODLData copyODL(ODLData d){
-	if(d.type==ODL_LIST){
-		ODLList * old=d.value.list;
-		d.value.list=allocList(old->top-old->bottom);
-		for(ODLData * it=old->bottom; it!=old->top; it++){
-			pushODL(d.value.list, copyODL(*it));
-		}
+/* Pins can nest; only the outermost one takes the epoch. */
+void pinODL(){
+	if(threadEpochODL==NULL){
+		registerEpochODL();
 	}
-	return d;
+	if(threadEpochODL->depth++>0){
+		return;
+	}
+	size_t epoch=__atomic_load_n(&epochODL, __ATOMIC_ACQUIRE);
+	__atomic_exchange_n(&threadEpochODL->state, epoch<<1|1, __ATOMIC_SEQ_CST);
 }
 
-void freeODL(ODLData * d);
+void unpinODL(){
+	if(--threadEpochODL->depth==0){
+		__atomic_store_n(&threadEpochODL->state, 0, __ATOMIC_RELEASE);
+	}
+}
 
-void popFromDictionary(ODLDictionary * dictionary, ODLWord name){
-	for(int i=0; i<dictionary->count; i++){
-		if(dictionary->defs[i].name==name){
-			ODLData old=popODL(&(dictionary->defs[i].code));
-			freeODL(&old);
+/* Moves the global epoch on if every pinned thread has seen it. Called with
+   epochLockODL held. */
+void advanceEpochODL(){
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	size_t epoch=epochODL;
+	for(ODLEpoch * it=epochsODL; it!=NULL; it=it->next){
+		size_t state=__atomic_load_n(&it->state, __ATOMIC_ACQUIRE);
+		if((state&1) && state>>1!=epoch){
 			return;
 		}
 	}
+	__atomic_store_n(&epochODL, epoch+1, __ATOMIC_RELEASE);
 }
 
-void freeListODL(ODLList * list){
+/* Frees what was retired at least two epochs ago. The retired list is
+   newest first, so that is all of it from the first such block on. Returns
+   whether anything is still waiting. */
+char reclaimODL(){
+	pthread_mutex_lock(&epochLockODL);
+	advanceEpochODL();
+	ODLRetired ** link=&retiredODL;
+	while(*link!=NULL && (*link)->epoch+2>epochODL){
+		link=&(*link)->next;
+	}
+	ODLRetired * expired=*link;
+	*link=NULL;
+	char waiting=retiredODL!=NULL;
+	pthread_mutex_unlock(&epochLockODL);
+	while(expired!=NULL){
+		ODLRetired * retired=expired;
+		expired=retired->next;
+		retired->release(retired->block);
+		free(retired);
+	}
+	return waiting;
+}
 
-	while(list->top>list->bottom){
-		list->top--;
-		ODLData * cur=list->top;
-		freeODL(cur);
+/* Reclaiming is tried every ODL_RECLAIM_EVERY blocks a thread retires,
+   rather than after each one. */
+#define ODL_RECLAIM_EVERY 64
+
+__thread size_t retiresODL=0;
+
+void retireODL(void * block, void (*release)(void * block)){
+	ODLRetired * retired=malloc(sizeof(ODLRetired));
+	retired->block=block;
+	retired->release=release;
+	pthread_mutex_lock(&epochLockODL);
+	retired->epoch=epochODL;
+	retired->next=retiredODL;
+	retiredODL=retired;
+	pthread_mutex_unlock(&epochLockODL);
+	if(++retiresODL%ODL_RECLAIM_EVERY==0){
+		reclaimODL();
 	}
-	free(list->bottom);
-	free(list);
 }
 
-void freeODL(ODLData * d){
+/* Waits until everything retired has been freed. The calling thread must
+   not be pinned. */
+void synchronizeODL(){
+	while(reclaimODL()){
+		sched_yield();
+	}
+}
+
+/* Names are found through the dictionary's table, an open addressing index
+   from the word to its position in entries plus one, 0 marking a free slot,
+   kept at most half full. Entries are allocated one at a time and never
+   move. A definer adds one in place while the table has room, storing the
+   index slot that leads to it with release after writing it; a full table
+   is copied into one twice the size, which is published whole with a
+   release store, read-copy-update style, and the old one retired. Readers
+   load the table with acquire, so they see either version complete. */
+struct ODLDefTable {
+	size_t alloc;
+	size_t mask;
+	ODLDefStack ** entries;
+	uint32_t slots[];
+};
+
+uint64_t mixHashODL(uint64_t h);
+
+ODLDefTable * allocDefTableODL(size_t alloc){
+	size_t size=16;
+	while(size<2*alloc){
+		size*=2;
+	}
+	ODLDefTable * table=calloc(1, sizeof(ODLDefTable)+size*sizeof(uint32_t)+alloc*sizeof(ODLDefStack *));
+	table->alloc=alloc;
+	table->mask=size-1;
+	table->entries=(ODLDefStack **)(table->slots+size);
+	return table;
+}
+
+void initDefsODL(ODLDictionary * dictionary, size_t alloc){
+	dictionary->count=0;
+	dictionary->defs=allocDefTableODL(alloc);
+	dictionary->shared=0;
+	pthread_mutex_init(&dictionary->lock, NULL);
+}
+
+/* The entry at position, which has to have been found already. */
+ODLDefStack * entryAtODL(ODLDictionary * dictionary, size_t position){
+	return __atomic_load_n(&dictionary->defs, __ATOMIC_ACQUIRE)->entries[position];
+}
+
+/* What is defined for entry. Readers of a shared dictionary have to be
+   pinned while they look at it. */
+ODLList * definitionsODL(ODLDefStack * entry){
+	return __atomic_load_n(&entry->code, __ATOMIC_ACQUIRE);
+}
+
+ODLDefStack * lookupEntryODL(ODLDictionary * dictionary, ODLWord name){
+	ODLDefTable * table=__atomic_load_n(&dictionary->defs, __ATOMIC_ACQUIRE);
+	size_t slot=mixHashODL((uintptr_t)name)&table->mask;
+	while(1){
+		uint32_t position=__atomic_load_n(table->slots+slot, __ATOMIC_ACQUIRE);
+		if(position==0){
+			return NULL;
+		}
+		if(table->entries[position-1]->name==name){
+			return table->entries[position-1];
+		}
+		slot=(slot+1)&table->mask;
+	}
+}
+
+void placeInTableODL(ODLDefTable * table, ODLDefStack * entry){
+	table->entries[entry->position]=entry;
+	size_t slot=mixHashODL((uintptr_t)entry->name)&table->mask;
+	while(table->slots[slot]!=0){
+		slot=(slot+1)&table->mask;
+	}
+	__atomic_store_n(table->slots+slot, entry->position+1, __ATOMIC_RELEASE);
+}
+
+/* Adds entry, whose position is the dictionary's count, to its table. */
+void indexEntryODL(ODLDictionary * dictionary, ODLDefStack * entry){
+	ODLDefTable * table=dictionary->defs;
+	if(entry->position>=table->alloc){
+		ODLDefTable * bigger=allocDefTableODL(2*table->alloc);
+		for(size_t i=0; i<entry->position; i++){
+			placeInTableODL(bigger, table->entries[i]);
+		}
+		placeInTableODL(bigger, entry);
+		__atomic_store_n(&dictionary->defs, bigger, __ATOMIC_RELEASE);
+		if(dictionary->shared){
+			retireODL(table, &free);
+		}else{
+			free(table);
+		}
+		return;
+	}
+	placeInTableODL(table, entry);
+}
+
+/* A dictionary with a parent is an overlay on it: names it has no
+   definition for are looked up in the parent, while anything defined goes
+   into the overlay and leaves the parent alone. */
+ODLDefStack * findEntryInDictionary(ODLDictionary * dictionary, char * name){
+	ODLDefStack * entry=lookupEntryODL(dictionary, name);
+	if(entry!=NULL && (dictionary->parent==NULL || definitionsODL(entry)->top>definitionsODL(entry)->bottom)){
+		return entry;
+	}
+	if(dictionary->parent!=NULL){
+		return findEntryInDictionary(dictionary->parent, name);
+	}
+	return NULL;
+}
+
+char resolveModuleODL(ODLDictionary * dictionary, ODLWord name);
+
+ODLDefStack * findInDictionary(ODLDictionary * dictionary, char * name){
+	ODLDefStack * entry=findEntryInDictionary(dictionary, name);
+	if(entry==NULL || definitionsODL(entry)->top==definitionsODL(entry)->bottom){
+		if(resolveModuleODL(dictionary, name)){
+			return findInDictionary(dictionary, name);
+		}
+		fprintf(outODL, "Could not find %s in dictionary\n", name);
+		abortODL();
+	}
+	return entry;
+}
+
+ODLList * allocDefinitionsODL(size_t size){
+	ODLList * code=malloc(sizeof(ODLList));
+	initList(code, size);
+	return code;
+}
+
+void freeDefinitionsODL(void * p){
+	ODLList * code=p;
+	while(code->top>code->bottom){
+		code->top--;
+		freeODL(code->top);
+	}
+	free(code->base);
+	free(code);
+}
+
+void releaseLockODL(void * lock){
+	pthread_mutex_unlock(lock);
+}
+
+/* Definers of a shared dictionary take turns, holding its lock so that an
+   abort lets go of it. */
+void lockDefinersODL(ODLDictionary * dictionary, ODLHold * hold){
+	pthread_mutex_lock(&dictionary->lock);
+	holdODL(hold, &releaseLockODL, &dictionary->lock);
+}
+
+void unlockDefinersODL(ODLDictionary * dictionary, ODLHold * hold){
+	unholdODL(hold);
+	pthread_mutex_unlock(&dictionary->lock);
+}
+
+/* Finds the entry for name, adding an empty one if there is none. */
+ODLDefStack * entryInDictionary(ODLDictionary * dictionary, ODLWord name){
+	ODLDefStack * entry=lookupEntryODL(dictionary, name);
+	if(entry!=NULL){
+		return entry;
+	}
+	ODLList * code=allocDefinitionsODL(8);
+	ODLHold hold;
+	if(dictionary->shared){
+		lockDefinersODL(dictionary, &hold);
+		entry=lookupEntryODL(dictionary, name);
+		if(entry!=NULL){
+			unlockDefinersODL(dictionary, &hold);
+			freeDefinitionsODL(code);
+			return entry;
+		}
+	}
+
+	entry=malloc(sizeof(ODLDefStack));
+	entry->name=name;
+	entry->position=dictionary->count;
+	entry->version=0;
+	entry->calls=0;
+	entry->backoff=0;
+	entry->jit=NULL;
+	entry->typed=NULL;
+	entry->code=code;
+	indexEntryODL(dictionary, entry);
+	dictionary->count++;
+	if(dictionary->shared){
+		unlockDefinersODL(dictionary, &hold);
+	}
+	return entry;
+}
+
+ODLData copyODL(ODLData d);
+
+/* Once the dictionary is shared, a definition stack a reader may be looking
+   at is never changed: a copy with the change made is published in its
+   place, and the old one retired along with whatever was popped off it.
+   That copy has d pushed on it, or if d is NULL is popped down to depth. */
+void replaceDefinitionsODL(ODLDictionary * dictionary, ODLDefStack * entry, size_t depth, ODLData * d){
+	ODLHold hold;
+	lockDefinersODL(dictionary, &hold);
+	ODLList * old=entry->code;
+	size_t keep=old->top-old->bottom;
+	if(d==NULL){
+		if(keep<=depth){
+			unlockDefinersODL(dictionary, &hold);
+			return;
+		}
+		keep=depth;
+	}
+	ODLList * code=allocDefinitionsODL(keep+1);
+	for(ODLData * it=old->bottom; it<old->bottom+keep; it++){
+		pushODL(code, copyODL(*it));
+	}
+	if(d!=NULL){
+		pushODL(code, *d);
+	}
+	__atomic_store_n(&entry->code, code, __ATOMIC_RELEASE);
+	__atomic_add_fetch(&entry->version, 1, __ATOMIC_RELEASE);
+	unlockDefinersODL(dictionary, &hold);
+	retireODL(old, &freeDefinitionsODL);
+}
+
+void pushDefinitionODL(ODLDictionary * dictionary, ODLDefStack * entry, ODLData d){
+	if(dictionary->shared){
+		replaceDefinitionsODL(dictionary, entry, 0, &d);
+		return;
+	}
+	pushODL(entry->code, d);
+	entry->version++;
+}
+
+/* Pops entry's definitions down to depth, if there are more than that. */
+void popDefinitionsODL(ODLDictionary * dictionary, ODLDefStack * entry, size_t depth){
+	if(dictionary->shared){
+		replaceDefinitionsODL(dictionary, entry, depth, NULL);
+		return;
+	}
+	while(entry->code->top-entry->code->bottom>depth){
+		entry->code->top--;
+		freeODL(entry->code->top);
+		entry->version++;
+	}
+}
+
+void releasePinODL(void * unused){
+	unpinODL();
+}
+
+/* Definers look at the dictionary too, so once it is shared they are pinned
+   while they do, held so that an abort unpins them. */
+void pinDefinerODL(ODLDictionary * dictionary, ODLHold * hold){
+	if(dictionary->shared){
+		pinODL();
+		holdODL(hold, &releasePinODL, NULL);
+	}
+}
+
+void unpinDefinerODL(ODLDictionary * dictionary, ODLHold * hold){
+	if(dictionary->shared){
+		unholdODL(hold);
+		unpinODL();
+	}
+}
+
+void pushToDictionary(ODLDictionary * dictionary, ODLWord name, ODLData d){
+	ODLHold hold;
+	pinDefinerODL(dictionary, &hold);
+	pushDefinitionODL(dictionary, entryInDictionary(dictionary, name), d);
+	unpinDefinerODL(dictionary, &hold);
+}
+
+/* Lets name's definitions be read from other threads, from then on until
+   the dictionary is freed. Called before any of them start. */
+void shareDictionaryODL(ODLDictionary * dictionary){
+	dictionary->shared=1;
+	sharedODL=1;
+}
+
+ODLData copyODL(ODLData d){
+	if(d.type==ODL_LIST){
+		retainODL(&d.value.list->refs);
+	}else if(d.type==ODL_BIGINT){
+		retainODL(&d.value.bigint->refs);
+	}else if(d.type==ODL_STRING){
+		retainODL(&d.value.string->refs);
+	}else if(d.type==ODL_SEQ){
+		retainODL(&d.value.seq->refs);
+	}else if(d.type==ODL_OBJECT){
+		retainODL(&d.value.object->refs);
+	}
+	return d;
+}
+
+ODLList * viewList(ODLList * list, ODLData * bottom, ODLData * top){
+	ODLList * view=smallBlockODL(sizeof(ODLList));
+	memoryODL.lists++;
+	memoryODL.made++;
+	view->alloc=0;
+	view->slots=ODL_SMALL_LIST;
+	view->refs=1;
+	view->backing=list->backing ? list->backing : list;
+	retainODL(&view->backing->refs);
+	view->base=NULL;
+	view->bottom=bottom;
+	view->top=top;
+	return view;
+}
+
+void freeListODL(ODLList * list);
+
+/* Makes the list held by d safe to mutate in place, copying it if it is a
+   view or is shared with another value. */
+ODLList * ownListODL(ODLData * d){
+	ODLList * old=d->value.list;
+	if(old->refs==1 && old->backing==NULL){
+		return old;
+	}
+	ODLList * list=allocList(old->top-old->bottom);
+	for(ODLData * it=old->bottom; it!=old->top; it++){
+		pushODL(list, copyODL(*it));
+	}
+	freeListODL(old);
+	d->value.list=list;
+	return list;
+}
+
+void popFromDictionary(ODLDictionary * dictionary, ODLWord name){
+	ODLHold hold;
+	pinDefinerODL(dictionary, &hold);
+	ODLDefStack * entry=lookupEntryODL(dictionary, name);
+	if(entry!=NULL){
+		size_t depth=entry->code->top-entry->code->bottom;
+		if(depth==0){
+			/* Aborts, as there is nothing to pop. */
+			popODL(entry->code);
+		}
+		popDefinitionsODL(dictionary, entry, depth-1);
+	}
+	unpinDefinerODL(dictionary, &hold);
+}
+
+void freeListODL(ODLList * list){
+	if(releaseRefODL(&list->refs)>0){
+		return;
+	}
+	memoryODL.lists--;
+	memoryODL.bytes-=sizeof(ODLList);
+	if(list->backing){
+		freeListODL(list->backing);
+		releaseBlockODL(list);
+		return;
+	}
+	while(list->top>list->bottom){
+		list->top--;
+		ODLData * cur=list->top;
+		freeODL(cur);
+	}
+	memoryODL.bytes-=list->alloc*sizeof(ODLData);
+	if(list->base!=(ODLData *)(list+1)){
+		free(list->base);
+	}
+	if(list->slots==ODL_SMALL_LIST){
+		releaseBlockODL(list);
+	}else{
+		free(list);
+	}
+}
+
+void freeObjectODL(ODLObject object);
+
+void freeODL(ODLData * d){
 	if(d->type==ODL_LIST){
 		freeListODL(d->value.list);
+	}else if(d->type==ODL_BIGINT){
+		freeBigInt(d->value.bigint);
+	}else if(d->type==ODL_STRING){
+		freeString(d->value.string);
+	}else if(d->type==ODL_SEQ){
+		freeSeq(d->value.seq);
+	}else if(d->type==ODL_OBJECT){
+		freeObjectODL(d->value.object);
 	}
 }
 
-void addBuiltin(ODLDictionary * dictionary, ODLWord name, ODLBuiltin builtin, ODLWordMap * map){
+/* Releases for holdODL. */
+void releaseValueODL(void * d){
+	freeODL(d);
+}
+
+void releaseListODL(void * list){
+	freeListODL(list);
+}
+
+/* Holds a value, which stays the caller's; the hold sees it change. */
+void holdValueODL(ODLHold * hold, ODLData * d){
+	holdODL(hold, &releaseValueODL, d);
+}
+
+void addBuiltinODL(ODLDictionary * dictionary, ODLWord name, ODLBuiltin builtin, char * symbol, int arity, ODLWordMap * map){
 	ODLData d;
 	d.type=ODL_BUILTIN;
-	d.value.builtin=builtin;
+	d.value.builtin=malloc(sizeof(ODLBuiltinDef));
+	d.value.builtin->call=builtin;
+	d.value.builtin->arity=arity;
+	d.value.builtin->symbol=symbol+(symbol[0]=='&');
+	d.value.builtin->next=dictionary->builtins;
+	dictionary->builtins=d.value.builtin;
 
 	pushToDictionary(dictionary, findInWordMap(name, map), d);
 }
 
+#define addBuiltin(dictionary, name, builtin, arity, map) addBuiltinODL(dictionary, name, builtin, #builtin, arity, map)
+
 void pushStackODL(ODLList * to, ODLList * source){
-	while(source->top!=source->bottom){
-		ODLData d=popODL(source);
-		pushODL(to, d);
+	if(source->refs==1 && source->backing==NULL){
+		while(source->top!=source->bottom){
+			ODLData d=popODL(source);
+			pushODL(to, d);
+		}
+		return;
+	}
+	for(ODLData * it=source->top; it!=source->bottom;){
+		it--;
+		pushODL(to, copyODL(*it));
 	}
 }
 
 void unrollODL(ODLList * stack, ODLDictionary * dictionary);
 
-void executeODL(ODLList * stack, ODLDictionary * dictionary){
-	while(stack->top>stack->bottom){
-		ODLData * cur=stack->top-1;
-		
-		if(cur->type==ODL_WORD){
+char runJitODL(ODLList * stack, ODLDictionary * dictionary, ODLDefStack * entry);
 
-			ODLData def=findInDictionary(dictionary, cur->value.word);
-			stack->top--;
-			def=copyODL(def);
-			pushODL(stack, def);
-			unrollODL(stack, dictionary);
-		}else if(cur->type==ODL_BUILTIN){
-			stack->top--;
-			cur->value.builtin(stack, dictionary);
-		}else{
+ODLList * typedBodyODL(ODLDictionary * dictionary, ODLDefStack * entry);
+
+char inferODL(ODLDictionary * dictionary, ODLDefStack * entry);
+
+ODLFrame * pushFrameODL(ODLDictionary * dictionary, ODLBuiltin resume, int remaining){
+	ODLControl * control=&dictionary->control;
+	if(control->count>=control->alloc){
+		reserveODL(control->alloc*sizeof(ODLFrame));
+		control->alloc*=2;
+		control->frames=realloc(control->frames, control->alloc*sizeof(ODLFrame));
+	}
+	ODLFrame * frame=control->frames+control->count++;
+	frame->resume=resume;
+	frame->base=control->values.top-control->values.bottom;
+	frame->remaining=remaining;
+	frame->state=NULL;
+	frame->release=NULL;
+	return frame;
+}
+
+void resumeFrameODL(ODLList * stack, ODLDictionary * dictionary){
+	ODLControl * control=&dictionary->control;
+	ODLFrame frame=control->frames[--control->count];
+	ODLData * base=control->values.bottom+frame.base;
+	for(ODLData * it=control->values.top; it>base;){
+		it--;
+		pushODL(stack, *it);
+	}
+	control->values.top=base;
+	control->state=frame.state;
+	frame.resume(stack, dictionary);
+}
+
+/* Calls the builtin straight away if its arguments are already values,
+   otherwise leaves a frame to collect them. */
+void callBuiltinODL(ODLList * stack, ODLDictionary * dictionary, ODLBuiltinDef * builtin){
+	int arity=builtin->arity;
+	if(stack->top-stack->bottom>=arity){
+		ODLData * it=stack->top;
+		while(it>stack->top-arity && (it-1)->type!=ODL_WORD && (it-1)->type!=ODL_BUILTIN){
+			it--;
+		}
+		if(it==stack->top-arity){
+			builtin->call(stack, dictionary);
 			return;
 		}
 	}
+	pushFrameODL(dictionary, builtin->call, arity);
+}
+
+/* Runs the stack until a value is on top or the stack is empty, with no
+   frames left above base. Builtins never call back into this to evaluate
+   their arguments, they push frames instead, so the C stack stays flat
+   however deep the Odd code goes. All the state is in the stack and the
+   control stack, so it can also stop after a number of steps and be called
+   again later to carry on; it returns 0 if it did. */
+char runODL(ODLList * stack, ODLDictionary * dictionary, size_t base, size_t steps){
+	ODLControl * control=&dictionary->control;
+	while(1){
+		if(steps--==0){
+			return 0;
+		}
+		stepODL();
+		if(stack->top>stack->bottom){
+			ODLData * cur=stack->top-1;
+
+			if(cur->type==ODL_WORD){
+
+				ODLDefStack * entry=findInDictionary(dictionary, cur->value.word);
+				ODLData def=*(definitionsODL(entry)->top-1);
+				stack->top--;
+				if(def.type==ODL_LIST && runJitODL(stack, dictionary, entry)){
+					continue;
+				}
+				if(entry->typed!=NULL && dictionary->parent==NULL){
+					ODLList * body=typedBodyODL(dictionary, entry);
+					if(body!=NULL){
+						def.value.list=body;
+					}
+				}
+				def=copyODL(def);
+				pushODL(stack, def);
+				unrollODL(stack, dictionary);
+				continue;
+			}
+			if(cur->type==ODL_BUILTIN){
+				stack->top--;
+				callBuiltinODL(stack, dictionary, cur->value.builtin);
+				continue;
+			}
+		}
+
+		if(control->count==base){
+			return 1;
+		}
+		ODLFrame * frame=control->frames+control->count-1;
+		if(frame->remaining>0){
+			pushODL(&control->values, popODL(stack));
+			if(--frame->remaining>0){
+				continue;
+			}
+		}
+		resumeFrameODL(stack, dictionary);
+	}
+}
+
+void executeODL(ODLList * stack, ODLDictionary * dictionary){
+	runODL(stack, dictionary, dictionary->control.count, SIZE_MAX);
 }
 
 void unrollODL(ODLList * stack, ODLDictionary * dictionary){
@@ -397,29 +1827,25 @@ void unrollODL(ODLList * stack, ODLDictionary * dictionary){
 }
 
 void evalODLB(ODLList * stack, ODLDictionary * dictionary){
-	executeODL(stack, dictionary);
 	unrollODL(stack, dictionary);
 }
 
 void listODLB(ODLList * stack, ODLDictionary * dictionary){
 
-	executeODL(stack, dictionary);
-
 	ODLData top=popODL(stack);
 
 	if(top.type!=ODL_INT){
-		printf("1st arg to list was not an integer");
-		exit(1);
+		fprintf(outODL, "1st arg to list was not an integer");
+		abortODL();
 	}
-	int count=top.value.integer;
-	ODLList * newList=allocList(count);
-
-	if(count>stack->top-stack->bottom){
-		printf("Empty stack in list\n");
-		exit(1);
+	ODLInt count=top.value.integer;
+	if(count<0 || count>stack->top-stack->bottom){
+		fprintf(outODL, "Empty stack in list\n");
+		abortODL();
 	}
+	ODLList * newList=allocList(count);
 
-	for(int i=0; i<count; i++){
+	for(ODLInt i=0; i<count; i++){
 		ODLData t=popODL(stack);
 		pushODL(newList, t);
 	}
@@ -433,65 +1859,172 @@ void listODLB(ODLList * stack, ODLDictionary * dictionary){
 
 void ifODLB(ODLList * stack, ODLDictionary * dictionary){
 
-	executeODL(stack, dictionary);
 	ODLData top=popODL(stack);
 
 	if(top.type!=ODL_INT){
-		printf("1st arg to if was not an integer");
+		fprintf(outODL, "1st arg to if was not an integer");
 		dumpODLData(top, 0);
-		exit(1);
+		freeODL(&top);
+		abortODL();
 	}
 	char cond=(top.value.integer!=0);
 
-	executeODL(stack, dictionary);
 	ODLData truePath=popODL(stack);
 
-	executeODL(stack, dictionary);
-
 	ODLData falsePath=popODL(stack);
 
 	pushODL(stack, cond ? truePath : falsePath);
+	freeODL(cond ? &falsePath : &truePath);
 
 	unrollODL(stack, dictionary);
 }
 
+ODLBuiltinDef lazyEvalODL={&evalODLB, 1, "evalODLB"};
+
+char isWordODL(ODLData * d, char * word){
+	return d->type==ODL_WORD && strcmp(d->value.word, word)==0;
+}
+
+char stackEffectODL(ODLDefStack * entry, int * in, int * out);
+
+char builtinEffectODL(ODLBuiltinDef * builtin, int * in, int * out);
+
+/* The lazy words take their branches, or their second operand, off the
+   stack as tokens before anything evaluates them, so the one that is not
+   needed is dropped unevaluated. Where an expression ends is worked out from
+   what its tokens take and leave: a literal leaves a value, ( ... ), $ name
+   and list N followed by N tokens are one value however many tokens they
+   span, and a word or builtin takes and leaves what effect says it does.
+   Returns the number of tokens in the expression whose first token is
+   high[-1], or 0 if that can not be told, as for a word whose effect is not
+   known. */
+size_t expressionExtentODL(ODLList * stack, ODLData * high, ODLDictionary * dictionary){
+	ODLData * it=high;
+	ptrdiff_t need=1;
+	while(need>0){
+		if(it<=stack->bottom){
+			return 0;
+		}
+		ODLData * token=--it;
+		int in=0;
+		int out=1;
+		if(isWordODL(token, "(") || isWordODL(token, "`(")){
+			int depth=1;
+			while(depth>0){
+				if(--it<stack->bottom){
+					return 0;
+				}
+				if(isWordODL(it, "(") || isWordODL(it, "`(")){
+					depth++;
+				}else if(isWordODL(it, ")")){
+					depth--;
+				}
+			}
+		}else if(isWordODL(token, "$")){
+			if(--it<stack->bottom){
+				return 0;
+			}
+		}else if(isWordODL(token, "list") && it>stack->bottom && (it-1)->type==ODL_INT
+			&& (it-1)->value.integer>=0 && (it-1)->value.integer<=it-1-stack->bottom){
+			it-=1+(it-1)->value.integer;
+		}else if(token->type==ODL_WORD){
+			ODLDefStack * entry=findEntryInDictionary(dictionary, token->value.word);
+			if(entry==NULL || !stackEffectODL(entry, &in, &out)){
+				return 0;
+			}
+		}else if(token->type==ODL_BUILTIN && !builtinEffectODL(token->value.builtin, &in, &out)){
+			return 0;
+		}
+		need+=in-out;
+	}
+	return need==0 ? high-it : 0;
+}
+
+/* Drops the tokens from low up to the top of the stack but the count of
+   them starting at keep, which move down to low. */
+void keepTokensODL(ODLList * stack, ODLData * low, ODLData * keep, size_t count){
+	for(ODLData * it=low; it<stack->top; it++){
+		if(it<keep || it>=keep+count){
+			freeODL(it);
+		}
+	}
+	memmove(low, keep, count*sizeof(ODLData));
+	stack->top=low+count;
+}
+
+/* lazy_if cond a b is if cond a b evaluating only the branch taken, which
+   is then unrolled as if would. A branch of list N and N tokens is taken by
+   leaving the tokens in place, what unrolling the list would give, without
+   building it. Where the extent of a branch can not be told it is if. */
+void lazyIfODLB(ODLList * stack, ODLDictionary * dictionary){
+	ODLData top=popODL(stack);
+	if(top.type!=ODL_INT){
+		fprintf(outODL, "1st arg to lazy_if was not an integer");
+		dumpODLData(top, 0);
+		freeODL(&top);
+		abortODL();
+	}
+	size_t trueExtent=expressionExtentODL(stack, stack->top, dictionary);
+	size_t falseExtent=trueExtent>0 ? expressionExtentODL(stack, stack->top-trueExtent, dictionary) : 0;
+	if(falseExtent==0){
+		pushODL(stack, top);
+		pushFrameODL(dictionary, &ifODLB, 3);
+		return;
+	}
+	ODLData * low=stack->top-trueExtent-falseExtent;
+	if(top.value.integer!=0){
+		keepTokensODL(stack, low, stack->top-trueExtent, trueExtent);
+	}else{
+		keepTokensODL(stack, low, low, falseExtent);
+	}
+	ODLData * first=stack->top-1;
+	if(first-low>=1 && isWordODL(first, "list") && (first-1)->type==ODL_INT && (first-1)->value.integer==first-1-low){
+		stack->top-=2;
+		return;
+	}
+	ODLData eval;
+	eval.type=ODL_BUILTIN;
+	eval.value.builtin=&lazyEvalODL;
+	pushODL(stack, eval);
+}
+
 void carryODLB(ODLList * stack, ODLDictionary * dictionary){
 	
-	executeODL(stack, dictionary);
 	ODLData d=popODL(stack);
 	
 	//dumpODLData(d, 0);
 
-	executeODL(stack, dictionary);
-
-	pushODL(stack, d);
-	unrollODL(stack, dictionary);
+	pushFrameODL(dictionary, &unrollODL, 0);
+	pushODL(&dictionary->control.values, d);
 }
 
 void rawDefineODLB(ODLList * stack, ODLDictionary * dictionary){
-	executeODL(stack, dictionary);
 	ODLData named=popODL(stack);
 	if(named.type!=ODL_SYMBOL){
-		printf("define's first argument is something other than a symbol\n");
-		exit(1);
+		fprintf(outODL, "define's first argument is something other than a symbol\n");
+		freeODL(&named);
+		abortODL();
 	}else{
 		ODLWord name=named.value.word;
 		
 	
-		executeODL(stack, dictionary);
 		ODLData d=popODL(stack);
 
 		pushToDictionary(dictionary, name, d);
+		if(d.type==ODL_LIST && !inferODL(dictionary, findEntryInDictionary(dictionary, name))){
+			popFromDictionary(dictionary, name);
+			abortODL();
+		}
 	}
 	
 }
 
 void popDefineODLB(ODLList * stack, ODLDictionary * dictionary){
-	executeODL(stack, dictionary);
 	ODLData named=popODL(stack);
 	if(named.type!=ODL_SYMBOL){
-		printf("pop_define's first argument is something other than a symbol\n");
-		exit(1);
+		fprintf(outODL, "pop_define's first argument is something other than a symbol\n");
+		freeODL(&named);
+		abortODL();
 	}else{
 		ODLWord name=named.value.word;
 			
@@ -500,31 +2033,45 @@ void popDefineODLB(ODLList * stack, ODLDictionary * dictionary){
 	
 }
 
-void openParsedBracketODLB(ODLList * stack, ODLDictionary * dictionary){
-	
-	ODLList * newList=allocList(16);
-	ODLData * ele=stack->top-1;
-	while(1){
-		executeODL(stack, dictionary);
-		ODLData cur=popODL(stack);
-		if(cur.type==ODL_SYMBOL && strcmp(cur.value.word, ")")==0){
-			break;
-		}
-		pushODL(newList, cur);
-		ele=stack->top-1;
+void parsedBracketElementODLB(ODLList * stack, ODLDictionary * dictionary){
+	ODLData d=popODL(stack);
+	ODLData cur=popODL(stack);
+	if(cur.type==ODL_SYMBOL && strcmp(cur.value.word, ")")==0){
+		pushODL(stack, d);
+		return;
 	}
+	pushODL(d.value.list, cur);
+
+	pushFrameODL(dictionary, &parsedBracketElementODLB, 1);
+	pushODL(&dictionary->control.values, d);
+}
 
+void openParsedBracketODLB(ODLList * stack, ODLDictionary * dictionary){
+	
 	ODLData d;
 	d.type=ODL_LIST;
-	d.value.list=newList;
-	pushODL(stack, d);
+	d.value.list=allocList(0);
+
+	pushFrameODL(dictionary, &parsedBracketElementODLB, 1);
+	pushODL(&dictionary->control.values, d);
 }
 
-void openBracketODLB(ODLList * stack, ODLDictionary * dictionary){
+void scanBracketODL(ODLList * stack, ODLDictionary * dictionary, ODLList * newList);
+
+void bracketElementODLB(ODLList * stack, ODLDictionary * dictionary){
+	ODLData d=popODL(stack);
+	ODLData t=popODL(stack);
+	pushODL(d.value.list, t);
+	scanBracketODL(stack, dictionary, d.value.list);
+}
+
+/* Moves the words up to the matching close bracket into newList. A backtick
+   at the outer level evaluates the expression after it, so the scan is
+   suspended in a frame until its value arrives. */
+void scanBracketODL(ODLList * stack, ODLDictionary * dictionary, ODLList * newList){
 	
 	int depth=1;
 	ODLData * cur=stack->top;
-	ODLList * newList=allocList(16);
 	while(depth>0 && cur>stack->bottom){
 		cur=stack->top-1;
 		if(cur->type==ODL_WORD){
@@ -536,8 +2083,12 @@ void openBracketODLB(ODLList * stack, ODLDictionary * dictionary){
 				
 				popODL(stack);
 
-				executeODL(stack, dictionary);
-
+				ODLData d;
+				d.type=ODL_LIST;
+				d.value.list=newList;
+				pushFrameODL(dictionary, &bracketElementODLB, 1);
+				pushODL(&dictionary->control.values, d);
+				return;
 			}
 		}
 		
@@ -548,10 +2099,12 @@ void openBracketODLB(ODLList * stack, ODLDictionary * dictionary){
 	}
 	
 	if(depth>0){
-		printf("Missing close bracket\n");
-		exit(1);
+		fprintf(outODL, "Missing close bracket\n");
+		freeListODL(newList);
+		abortODL();
 	}
 
+
 	
 	ODLData d;
 	d.type=ODL_LIST;
@@ -560,10 +2113,13 @@ void openBracketODLB(ODLList * stack, ODLDictionary * dictionary){
 	
 }
 
+void openBracketODLB(ODLList * stack, ODLDictionary * dictionary){
+	scanBracketODL(stack, dictionary, allocList(0));
+}
 
 void parseODLB(ODLList * stack, ODLDictionary * dictionary){
-	printf("Misplaced backtick\n");
-	exit(1);
+	fprintf(outODL, "Misplaced backtick\n");
+	abortODL();
 }
 
 void closeBracketODLB(ODLList * stack, ODLDictionary * dictionary){
@@ -574,603 +2130,6103 @@ void closeBracketODLB(ODLList * stack, ODLDictionary * dictionary){
 }
 
 void swapODLB(ODLList * stack, ODLDictionary * dictionary){
-	executeODL(stack, dictionary);
 	ODLData cur=popODL(stack);
 	if(cur.type!=ODL_INT){
-		printf("Tried to swap with non-integer");
-		exit(1);
+		fprintf(outODL, "Tried to swap with non-integer");
+		freeODL(&cur);
+		abortODL();
 	}
-	int firstOffset=cur.value.integer+1;
+	ODLInt firstOffset=cur.value.integer;
 
-	executeODL(stack, dictionary);
 	cur=popODL(stack);
 	if(cur.type!=ODL_INT){
-		printf("Tried to swap with non-integer");
-		exit(1);
+		fprintf(outODL, "Tried to swap with non-integer");
+		freeODL(&cur);
+		abortODL();
 	}
-	int secondOffset=cur.value.integer+1;
+	ODLInt secondOffset=cur.value.integer;
 
-	if(stack->top-firstOffset<stack->bottom || stack->top-secondOffset<stack->bottom){
-		printf("Swap operation out of range\n");
-		exit(1);
+	if(firstOffset<0 || firstOffset>=stack->top-stack->bottom || secondOffset<0 || secondOffset>=stack->top-stack->bottom){
+		fprintf(outODL, "Swap operation out of range\n");
+		abortODL();
 	}
 
-	ODLData temp=*(stack->top-firstOffset);
-	*(stack->top-firstOffset)=*(stack->top-secondOffset);
-	*(stack->top-secondOffset)=temp;
+	ODLData temp=*(stack->top-firstOffset-1);
+	*(stack->top-firstOffset-1)=*(stack->top-secondOffset-1);
+	*(stack->top-secondOffset-1)=temp;
 }
 
 void discardODLB(ODLList * stack, ODLDictionary * dictionary){
-	executeODL(stack, dictionary);
 	ODLData cur=popODL(stack);
 	if(cur.type!=ODL_INT){
-		printf("Tried to discard with non-int");
-		exit(1);
+		fprintf(outODL, "Tried to discard with non-int");
+		freeODL(&cur);
+		abortODL();
 	}
-	for(int i=0; i<cur.value.integer; i++){
+	for(ODLInt i=0; i<cur.value.integer; i++){
 		ODLData d=popODL(stack);
 		freeODL(&d);
 	}
 }
 
 void pushODLB(ODLList * stack, ODLDictionary * dictionary){
-	executeODL(stack, dictionary);
 	ODLData cur=popODL(stack);
 	if(cur.type!=ODL_LIST){
-		printf("Tried to push with non-list");
-		exit(1);
+		fprintf(outODL, "Tried to push with non-list");
+		freeODL(&cur);
+		abortODL();
 	}
 
-	executeODL(stack, dictionary);
 	ODLData item=popODL(stack);
 
-	pushODL(cur.value.list, item);
+	pushODL(ownListODL(&cur), item);
 	
 	pushODL(stack, cur);
 }
 
+void mergeObjectsODL(ODLData * into, ODLData * from);
+
+/* merge a b appends the elements of list b to list a. Given two maps it is a
+   with the entries of b set in it. */
 void pushListODLB(ODLList * stack, ODLDictionary * dictionary){
-	executeODL(stack, dictionary);
 	ODLData cur=popODL(stack);
+	if(cur.type==ODL_OBJECT){
+		ODLData from=popODL(stack);
+		if(from.type!=ODL_OBJECT){
+			fprintf(outODL, "Tried to merge a map with non-object");
+			freeODL(&cur);
+			freeODL(&from);
+			abortODL();
+		}
+		mergeObjectsODL(&cur, &from);
+		freeODL(&from);
+		pushODL(stack, cur);
+		return;
+	}
 	if(cur.type!=ODL_LIST){
-		printf("Tried to push with non-list");
-		exit(1);
+		fprintf(outODL, "Tried to push with non-list");
+		freeODL(&cur);
+		abortODL();
 	}
 
-	executeODL(stack, dictionary);
 	ODLData copied=popODL(stack);
 	if(copied.type!=ODL_LIST){
-		printf("Tried to push with non-list");
-		exit(1);
+		fprintf(outODL, "Tried to push with non-list");
+		freeODL(&cur);
+		freeODL(&copied);
+		abortODL();
 	}
 
 	ODLList * list=copied.value.list;
+	ODLList * target=ownListODL(&cur);
 
-	for(ODLData * it=list->bottom; it!=list->top; it++){
-		pushODL(cur.value.list, *it);
+	if(list->refs==1 && list->backing==NULL){
+		for(ODLData * it=list->bottom; it!=list->top; it++){
+			pushODL(target, *it);
+		}
+		list->top=list->bottom;
+	}else{
+		for(ODLData * it=list->bottom; it!=list->top; it++){
+			pushODL(target, copyODL(*it));
+		}
 	}
-
-	list->top=list->bottom;
 	freeListODL(list);
 
 	pushODL(stack, cur);
 }
 
 void popODLB(ODLList * stack, ODLDictionary * dictionary){
-	executeODL(stack, dictionary);
 	ODLData * cur=stack->top-1;
 	if(cur->type!=ODL_LIST){
-		printf("Tried to pop with non-list");
-		exit(1);
+		fprintf(outODL, "Tried to pop with non-list");
+		abortODL();
 	}
 
-	ODLData d=popODL(cur->value.list);
+	ODLData d=popODL(ownListODL(cur));
 	freeODL(&d);
 }
 
 void peekODLB(ODLList * stack, ODLDictionary * dictionary){
-	executeODL(stack, dictionary);
 	ODLData cur=popODL(stack);
 	if(cur.type!=ODL_LIST){
-		printf("Tried to peek with non-list");
-		exit(1);
+		fprintf(outODL, "Tried to peek with non-list");
+		freeODL(&cur);
+		abortODL();
+	}
+
+	ODLList * list=cur.value.list;
+	if(list->top==list->bottom){
+		fprintf(outODL, "Tried to pop from an empty stack");
+		freeODL(&cur);
+		abortODL();
 	}
 
-	ODLData item=popODL(cur.value.list);
+	ODLData item=copyODL(*(list->top-1));
 	freeODL(&cur);
 	pushODL(stack, item);
 }
 
 void restODLB(ODLList * stack, ODLDictionary * dictionary){
-	executeODL(stack, dictionary);
 	ODLData * cur=stack->top-1;
+	if(cur->type==ODL_SEQ){
+		ODLSeq * seq=cur->value.seq;
+		if(seqEmpty(seq, dictionary)){
+			fprintf(outODL, "Tried to rest an empty list");
+			abortODL();
+		}
+		cur->value.seq=seq->tail;
+		retainODL(&seq->tail->refs);
+		freeSeq(seq);
+		return;
+	}
 	if(cur->type!=ODL_LIST){
-		printf("Tried to rest with non-list");
-		exit(1);
+		fprintf(outODL, "Tried to rest with non-list");
+		abortODL();
 	}
 
-	ODLData d=shiftODL(cur->value.list);
-	freeODL(&d);
+	ODLList * list=cur->value.list;
+	if(list->top==list->bottom){
+		fprintf(outODL, "Tried to rest an empty list");
+		abortODL();
+	}
+	if(list->refs==1){
+		ODLData d=shiftODL(list);
+		if(list->backing==NULL){
+			freeODL(&d);
+		}
+	}else{
+		cur->value.list=viewList(list, list->bottom+1, list->top);
+		releaseRefODL(&list->refs);
+	}
 
 }
 
 void unshiftODLB(ODLList * stack, ODLDictionary * dictionary){
-	executeODL(stack, dictionary);
 	ODLData cur=popODL(stack);
 	if(cur.type!=ODL_LIST){
-		printf("Tried to unshift with non-list");
-		exit(1);
+		fprintf(outODL, "Tried to unshift with non-list");
+		freeODL(&cur);
+		abortODL();
 	}
 
-	executeODL(stack, dictionary);
 	ODLData item=popODL(stack);
 
-	unshiftODL(cur.value.list, item);
+	unshiftODL(ownListODL(&cur), item);
 	
 	pushODL(stack, cur);
 }
 
 void getODLB(ODLList * stack, ODLDictionary * dictionary){
-	executeODL(stack, dictionary);
 	ODLData cur=popODL(stack);
-	if(cur.type!=ODL_LIST){
-		printf("Tried to get with non-list");
-		exit(1);
+	if(cur.type!=ODL_LIST && cur.type!=ODL_SEQ){
+		fprintf(outODL, "Tried to get with non-list");
+		freeODL(&cur);
+		abortODL();
 	}
 
-	executeODL(stack, dictionary);
 	ODLData index=popODL(stack);
 	if(index.type!=ODL_INT){
-		printf("Tried to get with non-integer");
-		exit(1);
+		fprintf(outODL, "Tried to get with non-integer");
+		freeODL(&cur);
+		freeODL(&index);
+		abortODL();
 	}
 
-	int i=index.value.integer;
+	ODLInt i=index.value.integer;
 	
 	if(i<0){
-		printf("Get index out of range");
-		exit(1);
+		fprintf(outODL, "Get index out of range");
+		freeODL(&cur);
+		abortODL();
+	}
+
+	if(cur.type==ODL_SEQ){
+		ODLHold hold;
+		holdValueODL(&hold, &cur);
+		ODLSeq * seq=cur.value.seq;
+		while(i>0 && (seq->forced || seq->source->at==NULL) && !seqEmpty(seq, dictionary)){
+			seq=seq->tail;
+			i--;
+		}
+		ODLData item;
+		if(!seq->forced && seq->source->at!=NULL){
+			if(i>=seq->source->remaining(seq->source)){
+				fprintf(outODL, "Get index out of range");
+				abortODL();
+			}
+			seq->source->at(seq->source, i, &item);
+		}else{
+			if(seqEmpty(seq, dictionary)){
+				fprintf(outODL, "Get index out of range");
+				abortODL();
+			}
+			item=copyODL(seq->head);
+		}
+		unholdODL(&hold);
+		freeSeq(cur.value.seq);
+
+		pushODL(stack, item);
+		return;
 	}
 
 	ODLList * list=cur.value.list;
-	if(list->top-list->bottom<i){
-		printf("Get index out of range");
-		exit(1);
+	if(list->top-list->bottom<=i){
+		fprintf(outODL, "Get index out of range");
+		freeODL(&cur);
+		abortODL();
 	}
 
-	ODLData item=*(list->bottom+i);
-	(list->bottom+i)->type=ODL_ERROR;
+	ODLData item=copyODL(*(list->bottom+i));
 	freeListODL(list);
 
 	pushODL(stack, item);
 }
 
+/* Walks the sequence, dropping each cell as it goes, so a sequence nothing
+   else refers to is counted in constant memory. The rest of an indexed
+   source is counted without reading it. */
+ODLInt seqLength(ODLSeq * seq, ODLDictionary * dictionary){
+	ODLData held;
+	held.type=ODL_SEQ;
+	held.value.seq=seq;
+	ODLHold hold;
+	holdValueODL(&hold, &held);
+	ODLInt length=0;
+	while(1){
+		if(!seq->forced && seq->source->remaining!=NULL){
+			length+=seq->source->remaining(seq->source);
+			break;
+		}
+		if(seqEmpty(seq, dictionary)){
+			break;
+		}
+		ODLSeq * tail=seq->tail;
+		retainODL(&tail->refs);
+		freeSeq(seq);
+		seq=tail;
+		held.value.seq=seq;
+		length++;
+	}
+	unholdODL(&hold);
+	freeSeq(seq);
+	return length;
+}
+
 void lengthODLB(ODLList * stack, ODLDictionary * dictionary){
-	executeODL(stack, dictionary);
 	ODLData cur=popODL(stack);
-	if(cur.type!=ODL_LIST){
-		printf("Tried length with non-list");
-		exit(1);
+	ODLInt length;
+	if(cur.type==ODL_SEQ){
+		length=seqLength(cur.value.seq, dictionary);
+	}else if(cur.type==ODL_LIST){
+		length=cur.value.list->top-cur.value.list->bottom;
+		freeODL(&cur);
+	}else if(cur.type==ODL_STRING){
+		length=cur.value.string->length;
+		freeODL(&cur);
+	}else if(cur.type==ODL_OBJECT){
+		length=cur.value.object->size;
+		freeODL(&cur);
+	}else{
+		fprintf(outODL, "Tried length with non-list");
+		freeODL(&cur);
+		abortODL();
 	}
-	int length=cur.value.list->top-cur.value.list->bottom;
 	cur.type=ODL_INT;
 	cur.value.integer=length;
 	pushODL(stack, cur);
 }
 
-void duplicateODLB(ODLList * stack, ODLDictionary * dictionary){
-	executeODL(stack, dictionary);
+void emptyODLB(ODLList * stack, ODLDictionary * dictionary){
 	ODLData cur=popODL(stack);
-	if(cur.type!=ODL_INT){
-		printf("Tried to duplicate with non-int");
-		exit(1);
-	}
-	int copies=cur.value.integer;
-	while(copies--){
-		ODLData cur=copyODL(*(stack->top-1));
-		pushODL(stack, cur);
+	char empty;
+	if(cur.type==ODL_LIST){
+		empty=cur.value.list->top==cur.value.list->bottom;
+	}else if(cur.type==ODL_SEQ){
+		ODLHold hold;
+		holdValueODL(&hold, &cur);
+		empty=seqEmpty(cur.value.seq, dictionary);
+		unholdODL(&hold);
+	}else if(cur.type==ODL_STRING){
+		empty=cur.value.string->length==0;
+	}else if(cur.type==ODL_OBJECT){
+		empty=cur.value.object->size==0;
+	}else{
+		fprintf(outODL, "Tried empty with non-list");
+		freeODL(&cur);
+		abortODL();
 	}
+
+	freeODL(&cur);
+	cur.type=ODL_INT;
+	cur.value.integer=empty;
+	pushODL(stack, cur);
 }
 
-void copyODLB(ODLList * stack, ODLDictionary * dictionary){
-	executeODL(stack, dictionary);
-	ODLData cur=popODL(stack);
-	if(cur.type!=ODL_INT){
-		printf("Tried to copy with non-int");
-		exit(1);
-	}
-	int source=cur.value.integer+1;
-	
-	cur=popODL(stack);
-	if(cur.type!=ODL_INT){
-		printf("Tried to copy with non-int");
-		exit(1);
+/* Takes the first element off the non-empty list or sequence in d, leaving
+   the rest in d. */
+ODLData shiftElementODL(ODLData * d){
+	if(d->type==ODL_SEQ){
+		ODLSeq * seq=d->value.seq;
+		ODLData item=copyODL(seq->head);
+		d->value.seq=seq->tail;
+		retainODL(&seq->tail->refs);
+		freeSeq(seq);
+		return item;
 	}
-	int dest=cur.value.integer+1;
-	
-	if(stack->top-dest<stack->bottom || stack->top-source<stack->bottom){
-		printf("Copy operation out of range\n");
-		exit(1);
+	ODLList * list=d->value.list;
+	if(list->refs==1){
+		ODLData item=shiftODL(list);
+		return list->backing ? copyODL(item) : item;
 	}
-	
-	ODLData * destp=stack->top-dest;
-	freeODL(destp);
-	*destp=copyODL(*(stack->top-source));
-
+	d->value.list=viewList(list, list->bottom+1, list->top);
+	releaseRefODL(&list->refs);
+	return copyODL(*list->bottom);
 }
 
-void asSymbolODLB(ODLList * stack, ODLDictionary * dictionary){
-
-	ODLData * cur=(stack->top-1);
-	if(cur->type==ODL_WORD){
-		cur->type=ODL_SYMBOL;
+void forEachStepODLB(ODLList * stack, ODLDictionary * dictionary);
+
+ODLBuiltinDef forEachStepODL={&forEachStepODLB, 1, "forEachStepODLB"};
+
+/* state is a list of the index of the name's dictionary entry, what is left
+   to iterate over and the body.
+   The body is pushed above a call to forEachStepODLB on the state, so the
+   next element is bound once the body has been evaluated and its values
+   taken. Nothing is nested, so a loop runs in constant space. */
+void forEachNextODL(ODLList * stack, ODLDictionary * dictionary, ODLData state){
+	ODLData * over=state.value.list->bottom+1;
+	ODLHold hold;
+	holdValueODL(&hold, &state);
+	char empty=over->type==ODL_SEQ ? seqEmpty(over->value.seq, dictionary) : over->value.list->top==over->value.list->bottom;
+	unholdODL(&hold);
+	if(empty){
+		freeODL(&state);
+		return;
 	}
-}
 
-void asWordODLB(ODLList * stack, ODLDictionary * dictionary){
-	
-	executeODL(stack, dictionary);
-	ODLData * cur=(stack->top-1);
-	if(cur->type!=ODL_SYMBOL){
-		printf("as-word with non-symbol");
-		exit(1);
+	ODLData item=shiftElementODL(over);
+	if(item.type==ODL_LIST){
+		ODLData wrapped;
+		wrapped.type=ODL_LIST;
+		wrapped.value.list=allocList(1);
+		pushODL(wrapped.value.list, item);
+		item=wrapped;
 	}
-	cur->type=ODL_WORD;
+	ODLDefStack * entry=entryAtODL(dictionary, state.value.list->bottom->value.integer);
+	pushDefinitionODL(dictionary, entry, item);
+
+	ODLData body=copyODL(state.value.list->bottom[2]);
+	pushODL(stack, state);
+	ODLData step;
+	step.type=ODL_BUILTIN;
+	step.value.builtin=&forEachStepODL;
+	pushODL(stack, step);
+	pushODL(stack, body);
+	unrollODL(stack, dictionary);
 }
 
+void forEachStepODLB(ODLList * stack, ODLDictionary * dictionary){
+	ODLData state=popODL(stack);
+	ODLDefStack * entry=entryAtODL(dictionary, state.value.list->bottom->value.integer);
+	popDefinitionsODL(dictionary, entry, entry->code->top-entry->code->bottom-1);
+	forEachNextODL(stack, dictionary, state);
+}
 
-
-typedef int (*intArithmeticCB)(int, int);
-typedef float (*floatArithmeticCB)(float, float);
-typedef int (*floatComparisonCB)(float, float);
-
-void genericArithmeticODLB(ODLList * stack, ODLDictionary * dictionary, intArithmeticCB iCb, floatArithmeticCB fCb){
-	executeODL(stack, dictionary);
-	ODLData first=popODL(stack);
-	if(first.type!=ODL_INT && first.type!=ODL_NUM){
-		printf("Tried arithmetic with non-number");
-		exit(1);
-	}
-	
-	executeODL(stack, dictionary);
-	ODLData second=popODL(stack);
-	if(second.type!=ODL_INT && second.type!=ODL_NUM){
-		printf("Tried arithmetic with non-number");
-		exit(1);
+void forEachODLB(ODLList * stack, ODLDictionary * dictionary){
+	ODLData name=popODL(stack);
+	if(name.type!=ODL_SYMBOL && name.type!=ODL_WORD){
+		fprintf(outODL, "Tried for_each with non-symbol name");
+		freeODL(&name);
+		abortODL();
 	}
-
-	ODLData d;	
-	if(first.type==ODL_INT && second.type==ODL_INT && iCb!=NULL){
-		d.type=ODL_INT;
-		d.value.integer=iCb(first.value.integer, second.value.integer);
-	}else{
-		d.type=ODL_NUM;
-		float f1=(first.type == ODL_INT ? (float)first.value.integer : first.value.num);
-		float f2=(second.type == ODL_INT ? (float)second.value.integer : second.value.num);
-		d.value.num=fCb(f1, f2);
+	ODLData over=popODL(stack);
+	if(over.type!=ODL_LIST && over.type!=ODL_SEQ){
+		fprintf(outODL, "Tried for_each with non-list");
+		freeODL(&over);
+		abortODL();
 	}
 
-	pushODL(stack, d);
+	ODLData body=popODL(stack);
+
+	ODLData state;
+	state.type=ODL_LIST;
+	state.value.list=allocList(3);
+	name.type=ODL_INT;
+	name.value.integer=entryInDictionary(dictionary, name.value.word)->position;
+	pushODL(state.value.list, name);
+	pushODL(state.value.list, over);
+	pushODL(state.value.list, body);
+	forEachNextODL(stack, dictionary, state);
 }
 
-int intAdd(int a, int b){ return a+b;}
-float floatAdd(float a, float b){ return a+b;}
+size_t readChunkSize=65536;
+
+/* Lines are sliced out of chunks of readChunkSize bytes. A line running off
+   the end of a chunk is moved to the start of the next one, which is made
+   larger if the line would not leave room to read more. */
+typedef struct ODLLineSource {
+	ODLSource source;
+	FILE * file;
+	ODLStr * chunk;
+	char * next;
+	char * end;
+} ODLLineSource;
+
+char nextLineODL(ODLSource * source, ODLData * out, ODLDictionary * dictionary){
+	ODLLineSource * lines=(ODLLineSource *)source;
+	while(1){
+		char * newline=lines->chunk ? memchr(lines->next, '\n', lines->end-lines->next) : NULL;
+		if(newline!=NULL || (lines->file==NULL && lines->next<lines->end)){
+			char * end=newline ? newline : lines->end;
+			if(end>lines->next && end[-1]=='\r'){
+				end--;
+			}
+			out->type=ODL_STRING;
+			out->value.string=sliceString(lines->chunk, lines->next, end-lines->next);
+			lines->next=newline ? newline+1 : lines->end;
+			return 1;
+		}
+		if(lines->file==NULL){
+			return 0;
+		}
 
-void addODLB(ODLList * stack, ODLDictionary * dictionary){
-	genericArithmeticODLB(stack, dictionary, &intAdd, &floatAdd);
+		size_t left=lines->end-lines->next;
+		size_t size=readChunkSize;
+		while(size<2*left){
+			size*=2;
+		}
+		ODLStr * chunk=allocString(size);
+		if(left>0){
+			memcpy(chunk->data, lines->next, left);
+		}
+		if(lines->chunk){
+			freeString(lines->chunk);
+		}
+		lines->chunk=chunk;
+		lines->next=chunk->data;
+		lines->end=chunk->data+left;
+
+		size_t count=fread(lines->end, 1, size-left, lines->file);
+		lines->end+=count;
+		if(count<size-left){
+			if(lines->file!=stdin){
+				fclose(lines->file);
+			}
+			lines->file=NULL;
+		}
+	}
 }
-int intMinus(int a, int b){ return a-b;}
-float floatMinus(float a, float b){ return a-b;}
 
-void minusODLB(ODLList * stack, ODLDictionary * dictionary){
-	genericArithmeticODLB(stack, dictionary, &intMinus, &floatMinus);
+void releaseLinesODL(ODLSource * source){
+	ODLLineSource * lines=(ODLLineSource *)source;
+	if(lines->file!=NULL && lines->file!=stdin){
+		fclose(lines->file);
+	}
+	if(lines->chunk){
+		freeString(lines->chunk);
+	}
+	free(lines);
 }
 
-int intMultiply(int a, int b){ return a*b;}
-float floatMultiply(float a, float b){ return a*b;}
-
-void multiplyODLB(ODLList * stack, ODLDictionary * dictionary){
-	genericArithmeticODLB(stack, dictionary, &intMultiply, &floatMultiply);
-}
+/* read_lines "path" is a lazy sequence of the lines of a file, without their
+   newlines or the \r before a CRLF. "-" reads the rest of stdin. */
+void readLinesODLB(ODLList * stack, ODLDictionary * dictionary){
+	ODLData cur=popODL(stack);
+	if(cur.type!=ODL_STRING){
+		fprintf(outODL, "Tried read_lines with non-string");
+		freeODL(&cur);
+		abortODL();
+	}
+	char path[cur.value.string->length+1];
+	memcpy(path, cur.value.string->text, cur.value.string->length);
+	path[cur.value.string->length]=0;
+	freeODL(&cur);
 
-float floatDivide(float a, float b){ return a/b;}
+	FILE * file=strcmp(path, "-")==0 ? stdin : fopen(path, "r");
+	if(file==NULL){
+		fprintf(outODL, "Could not open %s", path);
+		abortODL();
+	}
 
-void divideODLB(ODLList * stack, ODLDictionary * dictionary){
-	genericArithmeticODLB(stack, dictionary, NULL, &floatDivide);
+	ODLLineSource * lines=malloc(sizeof(ODLLineSource));
+	lines->source.next=&nextLineODL;
+	lines->source.release=&releaseLinesODL;
+	lines->source.remaining=NULL;
+	lines->source.at=NULL;
+	lines->file=file;
+	lines->chunk=NULL;
+	lines->next=NULL;
+	lines->end=NULL;
+
+	cur.type=ODL_SEQ;
+	cur.value.seq=allocSeq(&lines->source);
+	pushODL(stack, cur);
 }
 
-void genericComparisonODLB(ODLList * stack, ODLDictionary * dictionary, intArithmeticCB iCb, floatComparisonCB fCb){
-	executeODL(stack, dictionary);
-	ODLData first=popODL(stack);
-	if(first.type!=ODL_INT && first.type!=ODL_NUM){
-		printf("Tried magnitude comparison with non-number");
-		exit(1);
-	}
-	
+/* Evaluates body applied to arg on a stack of its own and returns the first
+   value that comes out. Sources are forced from inside builtins, so unlike
+   builtins they cannot leave a frame and let the evaluator carry on. */
+ODLData applyODL(ODLDictionary * dictionary, ODLData body, ODLData arg){
+	ODLList * stack=allocList(16);
+	pushODL(stack, arg);
+	pushODL(stack, body);
+	ODLHold hold;
+	holdODL(&hold, &releaseListODL, stack);
+	unrollODL(stack, dictionary);
 	executeODL(stack, dictionary);
-	ODLData second=popODL(stack);
-	if(second.type!=ODL_INT && second.type!=ODL_NUM){
-		printf("Tried magnitude comparison with non-number");
-		exit(1);
-	}
+	ODLData d=popODL(stack);
+	unholdODL(&hold);
+	freeListODL(stack);
+	return d;
+}
 
+ODLData seqValue(ODLSource * source){
 	ODLData d;
-	d.type=ODL_INT;	
-	if(first.type==ODL_INT && second.type==ODL_INT && iCb!=NULL){
-		d.value.integer=iCb(first.value.integer, second.value.integer);
-	}else{
-		float f1=(first.type == ODL_INT ? (float)first.value.integer : first.value.num);
-		float f2=(second.type == ODL_INT ? (float)second.value.integer : second.value.num);
-		d.value.integer=fCb(f1, f2);
-	}
-
-	pushODL(stack, d);
+	d.type=ODL_SEQ;
+	d.value.seq=allocSeq(source);
+	return d;
 }
 
+typedef struct ODLRangeSource {
+	ODLSource source;
+	ODLInt next;
+	ODLInt end;
+} ODLRangeSource;
 
-int intLessThan(int a, int b){
-	return (a < b);
+char nextRangeODL(ODLSource * source, ODLData * out, ODLDictionary * dictionary){
+	ODLRangeSource * range=(ODLRangeSource *)source;
+	if(range->next>=range->end){
+		return 0;
+	}
+	out->type=ODL_INT;
+	out->value.integer=range->next++;
+	return 1;
 }
 
-int floatLessThan(float a, float b){
-	return (a < b);
+size_t remainingRangeODL(ODLSource * source){
+	ODLRangeSource * range=(ODLRangeSource *)source;
+	return range->next<range->end ? (uint64_t)range->end-(uint64_t)range->next : 0;
 }
 
-void lessThanODLB(ODLList * stack, ODLDictionary * dictionary){
-	genericComparisonODLB(stack, dictionary, &intLessThan, &floatLessThan);
+void atRangeODL(ODLSource * source, size_t index, ODLData * out){
+	ODLRangeSource * range=(ODLRangeSource *)source;
+	out->type=ODL_INT;
+	out->value.integer=range->next+index;
 }
 
-int intLessThanEqual(int a, int b){
-	return (a <= b);
+void releaseSourceODL(ODLSource * source){
+	free(source);
 }
 
-int floatLessThanEqual(float a, float b){
-	return (a <= b);
+/* range start end is the ints from start up to but not including end. */
+void rangeODLB(ODLList * stack, ODLDictionary * dictionary){
+	ODLData start=popODL(stack);
+	ODLData end=popODL(stack);
+	if(start.type!=ODL_INT || end.type!=ODL_INT){
+		fprintf(outODL, "Tried range with non-int");
+		freeODL(&start);
+		freeODL(&end);
+		abortODL();
+	}
+	ODLRangeSource * range=malloc(sizeof(ODLRangeSource));
+	range->source.next=&nextRangeODL;
+	range->source.release=&releaseSourceODL;
+	range->source.remaining=&remainingRangeODL;
+	range->source.at=&atRangeODL;
+	range->next=start.value.integer;
+	range->end=end.value.integer;
+	pushODL(stack, seqValue(&range->source));
 }
 
-void lessThanEqualODLB(ODLList * stack, ODLDictionary * dictionary){
-	genericComparisonODLB(stack, dictionary, &intLessThanEqual, &floatLessThanEqual);
+/* Shared by the sources that evaluate a body. For iterate value is the last
+   element and for generate the state. For a pipeline body is the list of
+   stages and value the sequence being read. */
+typedef struct ODLBodySource {
+	ODLSource source;
+	ODLData body;
+	ODLData value;
+	char started;
+} ODLBodySource;
+
+void releaseBodySourceODL(ODLSource * source){
+	ODLBodySource * it=(ODLBodySource *)source;
+	freeODL(&it->body);
+	freeODL(&it->value);
+	free(it);
 }
 
-int intGreaterThan(int a, int b){
-	return (a > b);
+ODLBodySource * bodySource(ODLList * stack, char (*next)(ODLSource *, ODLData *, ODLDictionary *)){
+	ODLBodySource * it=malloc(sizeof(ODLBodySource));
+	it->source.next=next;
+	it->source.release=&releaseBodySourceODL;
+	it->source.remaining=NULL;
+	it->source.at=NULL;
+	it->body=popODL(stack);
+	it->value=popODL(stack);
+	it->started=0;
+	return it;
 }
 
-int floatGreaterThan(float a, float b){
-	return (a > b);
+char nextIterateODL(ODLSource * source, ODLData * out, ODLDictionary * dictionary){
+	ODLBodySource * it=(ODLBodySource *)source;
+	if(it->started){
+		ODLData next=applyODL(dictionary, copyODL(it->body), copyODL(it->value));
+		freeODL(&it->value);
+		it->value=next;
+	}
+	it->started=1;
+	*out=copyODL(it->value);
+	return 1;
 }
 
-void greaterThanODLB(ODLList * stack, ODLDictionary * dictionary){
-	genericComparisonODLB(stack, dictionary, &intGreaterThan, &floatGreaterThan);
+/* iterate body x is the endless sequence x, body x, body body x... */
+void iterateODLB(ODLList * stack, ODLDictionary * dictionary){
+	pushODL(stack, seqValue(&bodySource(stack, &nextIterateODL)->source));
 }
 
-int intGreaterThanEqual(int a, int b){
-	return (a >= b);
+char nextGenerateODL(ODLSource * source, ODLData * out, ODLDictionary * dictionary){
+	ODLBodySource * it=(ODLBodySource *)source;
+	if(it->value.type==ODL_ERROR){
+		return 0;
+	}
+	ODLData res=applyODL(dictionary, copyODL(it->body), copyODL(it->value));
+	freeODL(&it->value);
+	it->value.type=ODL_ERROR;
+	if(res.type!=ODL_LIST || (res.value.list->top-res.value.list->bottom!=0 && res.value.list->top-res.value.list->bottom!=2)){
+		fprintf(outODL, "Generator body must return ( ) or ( value state )");
+		freeODL(&res);
+		abortODL();
+	}
+
+	if(res.value.list->top==res.value.list->bottom){
+		freeODL(&res);
+		return 0;
+	}
+	*out=copyODL(res.value.list->bottom[0]);
+	it->value=copyODL(res.value.list->bottom[1]);
+	freeODL(&res);
+	return 1;
 }
 
-int floatGreaterThanEqual(float a, float b){
-	return (a >= b);
+/* generate body state evaluates body on state for each element. It returns
+   ( value next_state ) to produce value, or ( ) to end the sequence. */
+void generateODLB(ODLList * stack, ODLDictionary * dictionary){
+	pushODL(stack, seqValue(&bodySource(stack, &nextGenerateODL)->source));
 }
 
-void greaterThanEqualODLB(ODLList * stack, ODLDictionary * dictionary){
-	genericComparisonODLB(stack, dictionary, &intGreaterThanEqual, &floatGreaterThanEqual);
+typedef enum ODLStage {
+	ODL_MAP_STAGE,
+	ODL_FILTER_STAGE,
+} ODLStage;
+
+/* Chains of map and filter are fused into one pipeline, so no intermediate
+   lists are built. The stages are kept in a list of kind and body pairs,
+   outermost first, and are applied to each element from the last pair
+   back. With fusionEnabled off every map and filter is a pipeline of its
+   own, for comparing the two. */
+
+char fusionEnabled=1;
+
+char keepODL(ODLData * d){
+	if(d->type!=ODL_INT){
+		fprintf(outODL, "Filter body did not return an integer");
+		freeODL(d);
+		abortODL();
+	}
+	return d->value.integer!=0;
 }
 
-char checkEquality(ODLData * first, ODLData * second){
-	char res;
-	if(first->type!=second->type){
-		if((first->type==ODL_WORD && second->type==ODL_SYMBOL) || (second->type==ODL_WORD && first->type==ODL_SYMBOL)){
-			res=first->value.word==second->value.word;
-		}else if(first->type==ODL_INT && second->type==ODL_NUM){
-			res=(((float)first->value.integer) == second->value.num);
-		}else if(first->type==ODL_NUM && second->type==ODL_INT){
-			res=(((float)second->value.integer) == first->value.num);
-		}else{
-			res=0;
+/* Runs item through the stages. Returns 0 if a filter dropped it. Bodies
+   of consecutive maps are composed and evaluated in one go, as the body of
+   the outer map with the inner map's code as its last argument. */
+char runStagesODL(ODLDictionary * dictionary, ODLList * stages, ODLData * item){
+	ODLHold hold;
+	holdValueODL(&hold, item);
+	ODLData * it=stages->top;
+	while(it>stages->bottom){
+		it-=2;
+		if(it->value.integer==ODL_FILTER_STAGE){
+			ODLData keep=applyODL(dictionary, copyODL(it[1]), copyODL(*item));
+			if(!keepODL(&keep)){
+				unholdODL(&hold);
+				freeODL(item);
+				return 0;
+			}
+			continue;
 		}
-	}else{
-		switch(first->type){
-			case ODL_LIST:
-				printf("List equality nyi\n");
-				exit(1);
-			break;
-			case ODL_INT:
-				res=(first->value.integer==second->value.integer);
-			break;
-			case ODL_NUM:
-				res=(first->value.num==second->value.num);
-			break;
-			case ODL_WORD:
-			case ODL_SYMBOL:
-				res=first->value.word==second->value.word;
-			break;
-			case ODL_STRING:
-				res=!strcmp(first->value.string, second->value.string);
-			break;
-			default:
-				printf("Other types in equality nyi\n");
-				exit(1);
-			break;
+		ODLList * stack=allocList(16);
+		pushODL(stack, *item);
+		item->type=ODL_ERROR;
+		ODLHold stackHold;
+		holdODL(&stackHold, &releaseListODL, stack);
+		while(1){
+			pushODL(stack, copyODL(it[1]));
+			unrollODL(stack, dictionary);
+			if(it==stages->bottom || (it-2)->value.integer!=ODL_MAP_STAGE){
+				break;
+			}
+			it-=2;
 		}
+		executeODL(stack, dictionary);
+		*item=popODL(stack);
+		unholdODL(&stackHold);
+		freeListODL(stack);
 	}
-	return res;
+	unholdODL(&hold);
+	return 1;
 }
 
-void equalODLB(ODLList * stack, ODLDictionary * dictionary){
-	executeODL(stack, dictionary);
-	ODLData first=popODL(stack);
-
-	executeODL(stack, dictionary);
-	ODLData second=popODL(stack);
+char nextPipelineODL(ODLSource * source, ODLData * out, ODLDictionary * dictionary){
+	ODLBodySource * it=(ODLBodySource *)source;
+	while(!seqEmpty(it->value.value.seq, dictionary)){
+		*out=shiftElementODL(&it->value);
+		if(runStagesODL(dictionary, it->body.value.list, out)){
+			return 1;
+		}
+	}
+	return 0;
+}
 
-	char res=checkEquality(&first, &second);
+void pipelineStepODLB(ODLList * stack, ODLDictionary * dictionary);
 
-	ODLData d;
-	d.type=ODL_INT;
-	d.value.integer=res;
-	pushODL(stack, d);
-}
+ODLJitCode * compileJitStages(ODLDictionary * dictionary, ODLData * stage, int count, size_t elements);
 
-void genericLogicalODLB(ODLList * stack, ODLDictionary * dictionary, intArithmeticCB iCb){
-	executeODL(stack, dictionary);
-	ODLData first=popODL(stack);
-	if(first.type!=ODL_INT){
-		printf("Tried logical operator with non-int");
-		exit(1);
-	}
-	
-	executeODL(stack, dictionary);
-	ODLData second=popODL(stack);
-	if(second.type!=ODL_INT){
-		printf("Tried logical operator with non-int");
-		exit(1);
-	}
+char callJitStage(ODLDictionary * dictionary, ODLJitCode * jit, ODLData * arg, ODLInt * result);
 
-	ODLData d;
-	d.type=ODL_INT;	
-	d.value.integer=iCb(first.value.integer, second.value.integer);
+void releaseJit(ODLJitCode * jit);
 
-	pushODL(stack, d);
+/* Counts the maps in the run starting at stage, going outwards. */
+int mapRunODL(ODLList * stages, ODLData * stage){
+	int count=0;
+	while(stage>=stages->bottom && stage->value.integer==ODL_MAP_STAGE){
+		count++;
+		stage-=2;
+	}
+	return count;
 }
 
-int andLog(int a, int b){
-	return (a && b);
+/* A pipeline over a list collects its results into a new list. item is the
+   element going through the stages and remaining how many stages it still
+   has to go through. jits holds the compiled code for each filter and run of
+   maps at the index of its first stage, or NULL where it could not be
+   compiled. Stages that have not been compiled leave a frame for the result
+   of each filter and each run of maps, as for any other builtin, which owns
+   the pipeline meanwhile. The element is moved out while maps run on it,
+   leaving ODL_ERROR, which also marks an element a filter dropped. */
+typedef struct ODLPipeline {
+	ODLList * stages;
+	ODLData rest;
+	ODLList * results;
+	ODLData item;
+	size_t remaining;
+	ODLJitCode ** jits;
+} ODLPipeline;
+
+void compilePipelineODL(ODLDictionary * dictionary, ODLPipeline * pipeline, size_t elements){
+	ODLList * stages=pipeline->stages;
+	size_t count=(stages->top-stages->bottom)/2;
+	pipeline->jits=calloc(count, sizeof(ODLJitCode *));
+	for(size_t i=count; i>0;){
+		ODLData * stage=stages->bottom+(i-1)*2;
+		int run=stage->value.integer==ODL_MAP_STAGE ? mapRunODL(stages, stage) : 1;
+		pipeline->jits[i-1]=compileJitStages(dictionary, stage, run, elements);
+		i-=run;
+	}
 }
 
-void andODLB(ODLList * stack, ODLDictionary * dictionary){
-	genericLogicalODLB(stack, dictionary, &andLog);
+void releasePipelineODL(void * p){
+	ODLPipeline * pipeline=p;
+	size_t count=(pipeline->stages->top-pipeline->stages->bottom)/2;
+	for(size_t i=0; i<count; i++){
+		if(pipeline->jits[i]!=NULL){
+			releaseJit(pipeline->jits[i]);
+		}
+	}
+	free(pipeline->jits);
+	freeListODL(pipeline->stages);
+	freeODL(&pipeline->rest);
+	freeListODL(pipeline->results);
+	freeODL(&pipeline->item);
+	free(pipeline);
 }
 
-int orLog(int a, int b){
-	return (a || b);
+/* Runs the next stage of the element with compiled code, if it has been
+   compiled and its guards hold. */
+char runPipelineJitODL(ODLDictionary * dictionary, ODLPipeline * pipeline){
+	ODLJitCode * jit=pipeline->jits[pipeline->remaining-1];
+	ODLInt result;
+	if(jit==NULL || !callJitStage(dictionary, jit, &pipeline->item, &result)){
+		return 0;
+	}
+	ODLData * stage=pipeline->stages->bottom+(pipeline->remaining-1)*2;
+	if(stage->value.integer==ODL_MAP_STAGE){
+		pipeline->item.value.integer=result;
+		pipeline->remaining-=mapRunODL(pipeline->stages, stage);
+	}else if(result){
+		pipeline->remaining--;
+	}else{
+		pipeline->item.type=ODL_ERROR;
+		pipeline->remaining=0;
+	}
+	return 1;
 }
 
-void orODLB(ODLList * stack, ODLDictionary * dictionary){
-	genericLogicalODLB(stack, dictionary, &orLog);
+void pipelineNextODL(ODLList * stack, ODLDictionary * dictionary, ODLPipeline * pipeline){
+	ODLList * stages=pipeline->stages;
+	do{
+		if(pipeline->remaining>0){
+			continue;
+		}
+		if(pipeline->item.type!=ODL_ERROR){
+			pushODL(pipeline->results, pipeline->item);
+			pipeline->item.type=ODL_ERROR;
+		}
+		if(pipeline->rest.value.list->top==pipeline->rest.value.list->bottom){
+			ODLData out;
+			out.type=ODL_LIST;
+			out.value.list=pipeline->results;
+			retainODL(&pipeline->results->refs);
+			releasePipelineODL(pipeline);
+			pushODL(stack, out);
+			return;
+		}
+		pipeline->item=shiftElementODL(&pipeline->rest);
+		pipeline->remaining=(stages->top-stages->bottom)/2;
+	}while(pipeline->remaining==0 || runPipelineJitODL(dictionary, pipeline));
+
+	ODLFrame * frame=pushFrameODL(dictionary, &pipelineStepODLB, 1);
+	frame->state=pipeline;
+	frame->release=&releasePipelineODL;
+	ODLData * stage=stages->bottom+(pipeline->remaining-1)*2;
+	if(stage->value.integer==ODL_FILTER_STAGE){
+		pushODL(stack, copyODL(pipeline->item));
+		pushODL(stack, copyODL(stage[1]));
+		unrollODL(stack, dictionary);
+		return;
+	}
+	pushODL(stack, pipeline->item);
+	pipeline->item.type=ODL_ERROR;
+	while(pipeline->remaining>0 && stage->value.integer==ODL_MAP_STAGE){
+		pushODL(stack, copyODL(stage[1]));
+		unrollODL(stack, dictionary);
+		pipeline->remaining--;
+		stage-=2;
+	}
 }
 
-int xorLog(int a, int b){
-	return (!a != !b);
+void pipelineStepODLB(ODLList * stack, ODLDictionary * dictionary){
+	ODLPipeline * pipeline=dictionary->control.state;
+	ODLData result=popODL(stack);
+	if(pipeline->item.type==ODL_ERROR){
+		pipeline->item=result;
+	}else{
+		pipeline->remaining--;
+		ODLHold hold;
+		holdODL(&hold, &releasePipelineODL, pipeline);
+		char keep=keepODL(&result);
+		unholdODL(&hold);
+		if(!keep){
+			freeODL(&pipeline->item);
+			pipeline->item.type=ODL_ERROR;
+			pipeline->remaining=0;
+		}
+	}
+	pipelineNextODL(stack, dictionary, pipeline);
 }
 
-void xorODLB(ODLList * stack, ODLDictionary * dictionary){
-	genericLogicalODLB(stack, dictionary, &xorLog);
+void mapODLB(ODLList * stack, ODLDictionary * dictionary);
+
+void filterODLB(ODLList * stack, ODLDictionary * dictionary);
+
+/* Returns the stage d would start if it were evaluated, or -1 if it is not
+   map or filter. */
+int stageOfODL(ODLData * d, ODLDictionary * dictionary){
+	ODLData * def=d;
+	if(d->type==ODL_WORD){
+		ODLDefStack * entry=findEntryInDictionary(dictionary, d->value.word);
+		if(entry==NULL || entry->code->top==entry->code->bottom){
+			return -1;
+		}
+		def=entry->code->top-1;
+	}
+	if(def->type!=ODL_BUILTIN){
+		return -1;
+	}
+	if(def->value.builtin->call==&mapODLB){
+		return ODL_MAP_STAGE;
+	}
+	if(def->value.builtin->call==&filterODLB){
+		return ODL_FILTER_STAGE;
+	}
+	return -1;
 }
 
-void dumpODLB(ODLList * stack, ODLDictionary * dictionary){
-	printf("Start Dump");
-	dumpODLr(stack, 0, 1);
-	printf("\n");
+void pipelineStageODLB(ODLList * stack, ODLDictionary * dictionary);
+
+void pipelineSourceODLB(ODLList * stack, ODLDictionary * dictionary);
+
+/* Called with the body of a stage just added. If the next thing to be
+   evaluated is another map or filter it is taken into the pipeline instead
+   of being run, otherwise what it evaluates to is the source. */
+void pipelineArgumentODL(ODLList * stack, ODLDictionary * dictionary, ODLData stages){
+	int kind=fusionEnabled && stack->top>stack->bottom ? stageOfODL(stack->top-1, dictionary) : -1;
+	if(kind>=0){
+		stack->top--;
+		ODLData d;
+		d.type=ODL_INT;
+		d.value.integer=kind;
+		pushODL(stages.value.list, d);
+		pushFrameODL(dictionary, &pipelineStageODLB, 1);
+	}else{
+		pushFrameODL(dictionary, &pipelineSourceODLB, 1);
+	}
+	pushODL(&dictionary->control.values, stages);
 }
 
-void initDictionary(ODLDictionary * dictionary, ODLWordMap * map){
+void pipelineStageODLB(ODLList * stack, ODLDictionary * dictionary){
+	ODLData stages=popODL(stack);
+	pushODL(stages.value.list, popODL(stack));
+	pipelineArgumentODL(stack, dictionary, stages);
+}
 
-	dictionary->count=0;
-	dictionary->alloc=1024;
-	dictionary->defs=malloc(dictionary->alloc*sizeof(ODLDefStack));
-
-	addBuiltin(dictionary, "carry", &carryODLB, map);
-	addBuiltin(dictionary, "eval", &evalODLB, map);
-	addBuiltin(dictionary, "list", &listODLB, map);
-	addBuiltin(dictionary, "if", &ifODLB, map);
-	addBuiltin(dictionary, "define", &rawDefineODLB, map);
-	addBuiltin(dictionary, "pop_define", &popDefineODLB, map);
-	addBuiltin(dictionary, "(", &openBracketODLB, map);
-	addBuiltin(dictionary, "`(", &openParsedBracketODLB, map);
-	addBuiltin(dictionary, ")", &closeBracketODLB, map);
-	addBuiltin(dictionary, "`", &parseODLB, map);
-	addBuiltin(dictionary, "swap", &swapODLB, map);
-	addBuiltin(dictionary, "+", &addODLB, map);
-	addBuiltin(dictionary, "-", &minusODLB, map);
-	addBuiltin(dictionary, "*", &multiplyODLB, map);
-	addBuiltin(dictionary, "/", &divideODLB, map);
-	addBuiltin(dictionary, "=", &equalODLB, map);
-	addBuiltin(dictionary, "<", &lessThanODLB, map);
-	addBuiltin(dictionary, "<=", &lessThanEqualODLB, map);
-	addBuiltin(dictionary, ">", &greaterThanODLB, map);
-	addBuiltin(dictionary, ">=", &greaterThanEqualODLB, map);
-	addBuiltin(dictionary, "and", &andODLB, map);
-	addBuiltin(dictionary, "or", &orODLB, map);
-	addBuiltin(dictionary, "xor", &xorODLB, map);
-	addBuiltin(dictionary, "dump", &dumpODLB, map);
-	addBuiltin(dictionary, "as_symbol", &asSymbolODLB, map);
-	addBuiltin(dictionary, "$", &asSymbolODLB, map);
-	addBuiltin(dictionary, "as_word", &asWordODLB, map);
-	addBuiltin(dictionary, "@", &asWordODLB, map);
-	addBuiltin(dictionary, "push", &pushODLB, map);
-	addBuiltin(dictionary, "merge", &pushListODLB, map);
-	addBuiltin(dictionary, "pop", &popODLB, map);
-	addBuiltin(dictionary, "peek", &peekODLB, map);
-	addBuiltin(dictionary, "unshift", &unshiftODLB, map);
-	addBuiltin(dictionary, "rest", &restODLB, map);
-	addBuiltin(dictionary, "duplicate", &duplicateODLB, map);
-	addBuiltin(dictionary, "copy", &copyODLB, map);
-	addBuiltin(dictionary, "get", &getODLB, map);
-	addBuiltin(dictionary, "length", &lengthODLB, map);
-	addBuiltin(dictionary, "discard", &discardODLB, map);
-}
-
-void main(){
+void pipelineSourceODLB(ODLList * stack, ODLDictionary * dictionary){
+	ODLData stages=popODL(stack);
+	ODLData * over=stack->top-1;
+	if(over->type==ODL_SEQ){
+		pushODL(stack, stages);
+		pushODL(stack, seqValue(&bodySource(stack, &nextPipelineODL)->source));
+		return;
+	}
+	if(over->type!=ODL_LIST){
+		fprintf(outODL, "Tried map with non-list");
+		freeODL(&stages);
+		abortODL();
+	}
 
-	FILE* fd=fopen("./lib/std.odd", "r");
-	
-	fseek(fd, 0, SEEK_END);
-	int size=ftell(fd);
 
-	char * lib=malloc(size+1);
-	memset(lib, 0, size+1);
-	fseek(fd, 0, SEEK_SET);
-	if(!fread(lib, size, 1, fd)){
-		printf("Could not read stdlib %d\n", size);
-		exit(1);
+	ODLPipeline * pipeline=malloc(sizeof(ODLPipeline));
+	pipeline->stages=stages.value.list;
+	pipeline->rest=popODL(stack);
+	size_t elements=pipeline->rest.value.list->top-pipeline->rest.value.list->bottom;
+	pipeline->results=allocList(elements);
+	pipeline->item.type=ODL_ERROR;
+	pipeline->remaining=0;
+	compilePipelineODL(dictionary, pipeline, elements);
+	pipelineNextODL(stack, dictionary, pipeline);
+}
+
+void startPipelineODL(ODLList * stack, ODLDictionary * dictionary, ODLStage kind){
+	ODLData stages;
+	stages.type=ODL_LIST;
+	stages.value.list=allocList(8);
+	ODLData d;
+	d.type=ODL_INT;
+	d.value.integer=kind;
+	pushODL(stages.value.list, d);
+	pushODL(stages.value.list, popODL(stack));
+	pipelineArgumentODL(stack, dictionary, stages);
+}
+
+/* map body list evaluates body on each element and collects the results.
+   Mapping over a sequence gives a sequence, evaluated as it is read. */
+void mapODLB(ODLList * stack, ODLDictionary * dictionary){
+	startPipelineODL(stack, dictionary, ODL_MAP_STAGE);
+}
+
+/* filter body list keeps the elements body returns a non-zero int for. */
+void filterODLB(ODLList * stack, ODLDictionary * dictionary){
+	startPipelineODL(stack, dictionary, ODL_FILTER_STAGE);
+}
+
+void duplicateODLB(ODLList * stack, ODLDictionary * dictionary){
+	ODLData cur=popODL(stack);
+	if(cur.type!=ODL_INT){
+		fprintf(outODL, "Tried to duplicate with non-int");
+		freeODL(&cur);
+		abortODL();
 	}
-	fclose(fd);
+	ODLInt copies=cur.value.integer;
+	if(copies>0 && stack->top==stack->bottom){
+		fprintf(outODL, "Duplicate operation out of range\n");
+		abortODL();
+	}
+	while(copies-->0){
+		ODLData cur=copyODL(*(stack->top-1));
+		pushODL(stack, cur);
+	}
+}
+
+void copyODLB(ODLList * stack, ODLDictionary * dictionary){
+	ODLData cur=popODL(stack);
+	if(cur.type!=ODL_INT){
+		fprintf(outODL, "Tried to copy with non-int");
+		freeODL(&cur);
+		abortODL();
+	}
+	ODLInt source=cur.value.integer;
+	
+	cur=popODL(stack);
+	if(cur.type!=ODL_INT){
+		fprintf(outODL, "Tried to copy with non-int");
+		freeODL(&cur);
+		abortODL();
+	}
+	ODLInt dest=cur.value.integer;
 	
+	if(source<0 || source>=stack->top-stack->bottom || dest<0 || dest>=stack->top-stack->bottom){
+		fprintf(outODL, "Copy operation out of range\n");
+		abortODL();
+	}
 	
-	ODLWordMap map;
-	map.count=0;
-	map.alloc=1024;
-	map.wordList=malloc(map.alloc*sizeof(ODLWord));
+	ODLData * destp=stack->top-dest-1;
+	freeODL(destp);
+	*destp=copyODL(*(stack->top-source-1));
 
-	ODLDictionary * dictionary=malloc(sizeof(ODLDictionary));
+}
+
+void asSymbolODLB(ODLList * stack, ODLDictionary * dictionary){
 
-	initDictionary(dictionary, &map);
+	ODLData * cur=(stack->top-1);
+	if(cur->type==ODL_WORD){
+		cur->type=ODL_SYMBOL;
+	}
+}
+
+void asWordODLB(ODLList * stack, ODLDictionary * dictionary){
 	
+	ODLData * cur=(stack->top-1);
+	if(cur->type!=ODL_SYMBOL){
+		fprintf(outODL, "as-word with non-symbol");
+		abortODL();
+	}
+	cur->type=ODL_WORD;
+}
 
-	ODLList * stack=parseODL(lib, &map);
+typedef int (*intArithmeticCB)(ODLInt, ODLInt);
 
-	executeODL(stack, dictionary);
+typedef enum ODLArithmetic {
+	ODL_ADD,
+	ODL_MINUS,
+	ODL_MULTIPLY,
+	ODL_DIVIDE,
+} ODLArithmetic;
 
-	if(stack->top!=stack->bottom){
-		printf("Standard library returned output:\n");
-	
-		while(stack->top!=stack->bottom){
-			ODLData d=popODL(stack);
-			dumpODLData(d, 0);
+typedef enum ODLComparison {
+	ODL_LESS_THAN,
+	ODL_LESS_THAN_EQUAL,
+	ODL_GREATER_THAN,
+	ODL_GREATER_THAN_EQUAL,
+} ODLComparison;
+
+char isNumber(ODLData * d){
+	return d->type==ODL_INT || d->type==ODL_NUM || d->type==ODL_BIGINT;
+}
+
+ODLNum asNum(ODLData * d){
+	if(d->type==ODL_INT){
+		return (ODLNum)d->value.integer;
+	}
+	if(d->type==ODL_BIGINT){
+		return bigIntToNum(d->value.bigint);
+	}
+	return d->value.num;
+}
+
+ODLData bigIntArithmetic(ODLData * first, ODLData * second, ODLArithmetic op){
+	ODLBigInt * a=asBigInt(first);
+	ODLBigInt * b=asBigInt(second);
+	ODLBigInt * res;
+	if(op==ODL_MULTIPLY){
+		res=bigIntMultiply(a, b);
+	}else{
+		res=bigIntAdd(a, b, op==ODL_MINUS);
+	}
+	freeBigInt(a);
+	freeBigInt(b);
+	return bigIntResult(res);
+}
+
+/* op is always a constant at the call sites below, so once this is inlined
+   the ODL_INT path is a single overflow checked instruction. */
+static inline void genericArithmeticODLB(ODLList * stack, ODLDictionary * dictionary, ODLArithmetic op){
+	ODLData first=popODL(stack);
 	
-			executeODL(stack, dictionary);
+	ODLData second=popODL(stack);
+
+	ODLData d;
+	if(first.type==ODL_INT && second.type==ODL_INT && op!=ODL_DIVIDE){
+		ODLInt a=first.value.integer;
+		ODLInt b=second.value.integer;
+		char overflow;
+		switch(op){
+			case ODL_ADD:
+				overflow=__builtin_add_overflow(a, b, &d.value.integer);
+			break;
+			case ODL_MINUS:
+				overflow=__builtin_sub_overflow(a, b, &d.value.integer);
+			break;
+			default:
+				overflow=__builtin_mul_overflow(a, b, &d.value.integer);
+			break;
+		}
+		if(__builtin_expect(!overflow, 1)){
+			d.type=ODL_INT;
+			pushODL(stack, d);
+			return;
+		}
+	}
+
+	if(!isNumber(&first) || !isNumber(&second)){
+		fprintf(outODL, "Tried arithmetic with non-number");
+		freeODL(&first);
+		freeODL(&second);
+		abortODL();
+	}
+
+	if(first.type!=ODL_NUM && second.type!=ODL_NUM && op!=ODL_DIVIDE){
+		d=bigIntArithmetic(&first, &second, op);
+	}else{
+		ODLNum f1=asNum(&first);
+		ODLNum f2=asNum(&second);
+		d.type=ODL_NUM;
+		switch(op){
+			case ODL_ADD:
+				d.value.num=f1+f2;
+			break;
+			case ODL_MINUS:
+				d.value.num=f1-f2;
+			break;
+			case ODL_MULTIPLY:
+				d.value.num=f1*f2;
+			break;
+			case ODL_DIVIDE:
+				d.value.num=f1/f2;
+			break;
 		}
 	}
+	freeODL(&first);
+	freeODL(&second);
+
+	pushODL(stack, d);
+}
+
+void addODLB(ODLList * stack, ODLDictionary * dictionary){
+	genericArithmeticODLB(stack, dictionary, ODL_ADD);
+}
+
+void minusODLB(ODLList * stack, ODLDictionary * dictionary){
+	genericArithmeticODLB(stack, dictionary, ODL_MINUS);
+}
+
+void multiplyODLB(ODLList * stack, ODLDictionary * dictionary){
+	genericArithmeticODLB(stack, dictionary, ODL_MULTIPLY);
+}
+
+void divideODLB(ODLList * stack, ODLDictionary * dictionary){
+	genericArithmeticODLB(stack, dictionary, ODL_DIVIDE);
+}
+
+/* Returns <0, 0 or >0 as first is less than, equal to or greater than
+   second. Both must be numbers. */
+int compareNumbers(ODLData * first, ODLData * second){
+	if(first->type==ODL_INT && second->type==ODL_INT){
+		return (first->value.integer > second->value.integer)-(first->value.integer < second->value.integer);
+	}
+	if(first->type!=ODL_NUM && second->type!=ODL_NUM){
+		ODLBigInt * a=asBigInt(first);
+		ODLBigInt * b=asBigInt(second);
+		int res=bigIntCompare(a, b);
+		freeBigInt(a);
+		freeBigInt(b);
+		return res;
+	}
+	ODLNum f1=asNum(first);
+	ODLNum f2=asNum(second);
+	return (f1 > f2)-(f1 < f2);
+}
+
+static inline void genericComparisonODLB(ODLList * stack, ODLDictionary * dictionary, ODLComparison op){
+	ODLData first=popODL(stack);
 	
-	free(lib);
-	freeListODL(stack);
+	ODLData second=popODL(stack);
 
-	while(1){
-		printf("> ");
-		char * buffer=malloc(4096);
-		size_t bufsize=4096;
-		getline(&buffer,&bufsize,stdin);
+	ODLData d;
+	d.type=ODL_INT;
+	if(first.type==ODL_INT && second.type==ODL_INT){
+		ODLInt a=first.value.integer;
+		ODLInt b=second.value.integer;
+		switch(op){
+			case ODL_LESS_THAN:
+				d.value.integer=a<b;
+			break;
+			case ODL_LESS_THAN_EQUAL:
+				d.value.integer=a<=b;
+			break;
+			case ODL_GREATER_THAN:
+				d.value.integer=a>b;
+			break;
+			case ODL_GREATER_THAN_EQUAL:
+				d.value.integer=a>=b;
+			break;
+		}
+		pushODL(stack, d);
+		return;
+	}
 
-		stack=parseODL(buffer, &map);
+	if(!isNumber(&first) || !isNumber(&second)){
+		fprintf(outODL, "Tried magnitude comparison with non-number");
+		freeODL(&first);
+		freeODL(&second);
+		abortODL();
+	}
 
-		executeODL(stack, dictionary);
+	if(first.type==ODL_NUM || second.type==ODL_NUM){
+		ODLNum f1=asNum(&first);
+		ODLNum f2=asNum(&second);
+		switch(op){
+			case ODL_LESS_THAN:
+				d.value.integer=f1<f2;
+			break;
+			case ODL_LESS_THAN_EQUAL:
+				d.value.integer=f1<=f2;
+			break;
+			case ODL_GREATER_THAN:
+				d.value.integer=f1>f2;
+			break;
+			case ODL_GREATER_THAN_EQUAL:
+				d.value.integer=f1>=f2;
+			break;
+		}
+	}else{
+		int res=compareNumbers(&first, &second);
+		switch(op){
+			case ODL_LESS_THAN:
+				d.value.integer=res<0;
+			break;
+			case ODL_LESS_THAN_EQUAL:
+				d.value.integer=res<=0;
+			break;
+			case ODL_GREATER_THAN:
+				d.value.integer=res>0;
+			break;
+			case ODL_GREATER_THAN_EQUAL:
+				d.value.integer=res>=0;
+			break;
+		}
+	}
+	freeODL(&first);
+	freeODL(&second);
 
-		while(stack->top!=stack->bottom){
-			ODLData d=popODL(stack);
-			dumpODLData(d, 0);
+	pushODL(stack, d);
+}
 
-			executeODL(stack, dictionary);
+void lessThanODLB(ODLList * stack, ODLDictionary * dictionary){
+	genericComparisonODLB(stack, dictionary, ODL_LESS_THAN);
+}
+
+void lessThanEqualODLB(ODLList * stack, ODLDictionary * dictionary){
+	genericComparisonODLB(stack, dictionary, ODL_LESS_THAN_EQUAL);
+}
+
+void greaterThanODLB(ODLList * stack, ODLDictionary * dictionary){
+	genericComparisonODLB(stack, dictionary, ODL_GREATER_THAN);
+}
+
+void greaterThanEqualODLB(ODLList * stack, ODLDictionary * dictionary){
+	genericComparisonODLB(stack, dictionary, ODL_GREATER_THAN_EQUAL);
+}
+
+char checkEquality(ODLData * first, ODLData * second){
+	char res;
+	if(first->type!=second->type){
+		if((first->type==ODL_WORD && second->type==ODL_SYMBOL) || (second->type==ODL_WORD && first->type==ODL_SYMBOL)){
+			res=first->value.word==second->value.word;
+		}else if(isNumber(first) && isNumber(second)){
+			res=(compareNumbers(first, second)==0);
+		}else{
+			res=0;
 		}
-		freeListODL(stack);
+	}else{
+		switch(first->type){
+			case ODL_LIST:
+				fprintf(outODL, "List equality nyi\n");
+				abortODL();
+			break;
+			case ODL_INT:
+				res=(first->value.integer==second->value.integer);
+			break;
+			case ODL_NUM:
+				res=(first->value.num==second->value.num);
+			break;
+			case ODL_BIGINT:
+				res=(bigIntCompare(first->value.bigint, second->value.bigint)==0);
+			break;
+			case ODL_WORD:
+			case ODL_SYMBOL:
+				res=first->value.word==second->value.word;
+			break;
+			case ODL_STRING:
+				res=first->value.string->length==second->value.string->length
+					&& !memcmp(first->value.string->text, second->value.string->text, first->value.string->length);
+			break;
+			default:
+				fprintf(outODL, "Other types in equality nyi\n");
+				abortODL();
+			break;
+		}
+	}
+	return res;
+}
+
+void equalODLB(ODLList * stack, ODLDictionary * dictionary){
+	ODLData first=popODL(stack);
+
+	ODLData second=popODL(stack);
+
+	ODLHold firstHold, secondHold;
+	holdValueODL(&firstHold, &first);
+	holdValueODL(&secondHold, &second);
+	char res=checkEquality(&first, &second);
+	unholdODL(&secondHold);
+	unholdODL(&firstHold);
+	freeODL(&first);
+	freeODL(&second);
+
+
+	ODLData d;
+	d.type=ODL_INT;
+	d.value.integer=res;
+	pushODL(stack, d);
+}
+
+/* Sorting. Numbers are ordered as < orders them, strings bytewise and words
+   and symbols by name; values of different kinds can not be sorted together.
+   Lists of ints are radix sorted, anything else goes through a stable merge
+   sort. Each element is paired with its key, which for sort is the element
+   itself and for sort_by what the body gives for it. */
+typedef struct ODLSortItem {
+	ODLData key;
+	ODLData value;
+} ODLSortItem;
+
+enum {
+	ODL_SORT_NONE,
+	ODL_SORT_NUMBER,
+	ODL_SORT_STRING,
+	ODL_SORT_WORD,
+};
+
+#define ODL_SORT_RUN 32
+
+int sortKindODL(ODLData * d){
+	if(isNumber(d)){
+		return ODL_SORT_NUMBER;
+	}
+	if(d->type==ODL_STRING){
+		return ODL_SORT_STRING;
+	}
+	if(d->type==ODL_WORD || d->type==ODL_SYMBOL){
+		return ODL_SORT_WORD;
+	}
+	return ODL_SORT_NONE;
+}
+
+/* a and b must be of the same kind. */
+int compareKeysODL(ODLData * a, ODLData * b){
+	if(a->type==ODL_INT && b->type==ODL_INT){
+		return (a->value.integer > b->value.integer)-(a->value.integer < b->value.integer);
+	}
+	if(a->type==ODL_STRING){
+		size_t la=a->value.string->length;
+		size_t lb=b->value.string->length;
+		int res=memcmp(a->value.string->text, b->value.string->text, la<lb ? la : lb);
+		return res ? res : (la > lb)-(la < lb);
+	}
+	if(a->type==ODL_WORD || a->type==ODL_SYMBOL){
+		return strcmp(a->value.word, b->value.word);
+	}
+	return compareNumbers(a, b);
+}
+
+void insertionSortODL(ODLSortItem * items, size_t count){
+	for(size_t i=1; i<count; i++){
+		ODLSortItem cur=items[i];
+		size_t j=i;
+		while(j>0 && compareKeysODL(&items[j-1].key, &cur.key)>0){
+			items[j]=items[j-1];
+			j--;
+		}
+		items[j]=cur;
 	}
 }
+
+/* Bottom up, merging back and forth between items and scratch. Runs that
+   are already in order are copied without comparing each element. */
+void mergeSortODL(ODLSortItem * items, ODLSortItem * scratch, size_t count){
+	for(size_t i=0; i<count; i+=ODL_SORT_RUN){
+		insertionSortODL(items+i, count-i<ODL_SORT_RUN ? count-i : ODL_SORT_RUN);
+	}
+	ODLSortItem * from=items;
+	ODLSortItem * to=scratch;
+	for(size_t width=ODL_SORT_RUN; width<count; width*=2){
+		for(size_t start=0; start<count; start+=2*width){
+			size_t middle=start+width<count ? start+width : count;
+			size_t end=middle+width<count ? middle+width : count;
+			if(middle==end || compareKeysODL(&from[middle-1].key, &from[middle].key)<=0){
+				memcpy(to+start, from+start, (end-start)*sizeof(ODLSortItem));
+				continue;
+			}
+			size_t i=start, j=middle, k=start;
+			while(i<middle && j<end){
+				to[k++]=compareKeysODL(&from[j].key, &from[i].key)<0 ? from[j++] : from[i++];
+			}
+			memcpy(to+k, from+i, (middle-i)*sizeof(ODLSortItem));
+			k+=middle-i;
+			memcpy(to+k, from+j, (end-j)*sizeof(ODLSortItem));
+		}
+		ODLSortItem * swap=from;
+		from=to;
+		to=swap;
+	}
+	if(from!=items){
+		memcpy(items, from, count*sizeof(ODLSortItem));
+	}
+}
+
+/* Least significant digit first on the keys alone, with the index of each
+   item riding along, so only 16 bytes move per element and pass. Keys are
+   taken relative to the smallest, so only as many passes are made as the
+   range of the keys needs, and a pass whose digit every key shares is
+   skipped. */
+#define ODL_RADIX_BITS 11
+#define ODL_RADIX_PASSES ((64+ODL_RADIX_BITS-1)/ODL_RADIX_BITS)
+
+typedef struct ODLRadixItem {
+	uint64_t key;
+	size_t index;
+} ODLRadixItem;
+
+void radixSortODL(ODLSortItem * items, ODLSortItem * scratch, size_t count, char keysAreValues){
+	ODLInt min=items[0].key.value.integer;
+	ODLInt max=min;
+	for(size_t i=1; i<count; i++){
+		ODLInt v=items[i].key.value.integer;
+		min=v<min ? v : min;
+		max=v>max ? v : max;
+	}
+	uint64_t range=(uint64_t)max-(uint64_t)min;
+	int passes=0;
+	while(passes<ODL_RADIX_PASSES && range>>(passes*ODL_RADIX_BITS)){
+		passes++;
+	}
+
+	size_t mask=(1<<ODL_RADIX_BITS)-1;
+	size_t (*counts)[1<<ODL_RADIX_BITS]=calloc(ODL_RADIX_PASSES, sizeof(*counts));
+	ODLRadixItem * from=malloc(count*sizeof(ODLRadixItem));
+	ODLRadixItem * to=malloc(count*sizeof(ODLRadixItem));
+	for(size_t i=0; i<count; i++){
+		uint64_t key=(uint64_t)items[i].key.value.integer-(uint64_t)min;
+		from[i].key=key;
+		from[i].index=i;
+		for(int pass=0; pass<passes; pass++){
+			counts[pass][(key>>(pass*ODL_RADIX_BITS)) & mask]++;
+		}
+	}
+	for(int pass=0; pass<passes; pass++){
+		int shift=pass*ODL_RADIX_BITS;
+		if(counts[pass][(from[0].key>>shift) & mask]==count){
+			continue;
+		}
+		size_t offset=0;
+		for(size_t digit=0; digit<=mask; digit++){
+			size_t n=counts[pass][digit];
+			counts[pass][digit]=offset;
+			offset+=n;
+		}
+		for(size_t i=0; i<count; i++){
+			to[counts[pass][(from[i].key>>shift) & mask]++]=from[i];
+		}
+		ODLRadixItem * swap=from;
+		from=to;
+		to=swap;
+	}
+	if(keysAreValues){
+		/* The ints can be rebuilt from the keys, saving a gather. */
+		for(size_t i=0; i<count; i++){
+			items[i].key.value.integer=(ODLInt)(from[i].key+(uint64_t)min);
+			items[i].value=items[i].key;
+		}
+	}else{
+		for(size_t i=0; i<count; i++){
+			scratch[i]=items[from[i].index];
+		}
+		memcpy(items, scratch, count*sizeof(ODLSortItem));
+	}
+	free(from);
+	free(to);
+	free(counts);
+}
+
+/* Returns 0, sorting nothing, if the keys are not all of one kind. */
+char sortItemsODL(ODLSortItem * items, size_t count, char keysAreValues){
+	if(count==0){
+		return 1;
+	}
+	int kind=sortKindODL(&items[0].key);
+	char ints=1;
+	for(size_t i=0; i<count; i++){
+		if(kind==ODL_SORT_NONE || sortKindODL(&items[i].key)!=kind){
+			return 0;
+		}
+		ints&=items[i].key.type==ODL_INT;
+	}
+	ODLSortItem * scratch=malloc(count*sizeof(ODLSortItem));
+	if(ints && count>=64){
+		radixSortODL(items, scratch, count, keysAreValues);
+	}else{
+		mergeSortODL(items, scratch, count);
+	}
+	free(scratch);
+	return 1;
+}
+
+/* The list or the forced sequence held by d, owned so it can be reordered
+   in place. */
+ODLList * ownElementsODL(ODLData * d, ODLDictionary * dictionary, char * name){
+	if(d->type==ODL_LIST){
+		return ownListODL(d);
+	}
+	if(d->type!=ODL_SEQ){
+		fprintf(outODL, "Tried to %s with non-list", name);
+		freeODL(d);
+		abortODL();
+	}
+	ODLList * list=allocList(16);
+	ODLHold seqHold, listHold;
+	holdValueODL(&seqHold, d);
+	holdODL(&listHold, &releaseListODL, list);
+	while(!seqEmpty(d->value.seq, dictionary)){
+		pushODL(list, shiftElementODL(d));
+	}
+	unholdODL(&listHold);
+	unholdODL(&seqHold);
+	freeODL(d);
+	d->type=ODL_LIST;
+	d->value.list=list;
+	return list;
+}
+
+/* Sorts list by the keys already in items, which hold its elements, and
+   pushes it. The items are freed. */
+void finishSortODL(ODLList * stack, ODLData d, ODLSortItem * items, char owned){
+	ODLList * list=d.value.list;
+	size_t count=list->top-list->bottom;
+	if(!sortItemsODL(items, count, !owned)){
+		if(owned){
+			for(size_t i=0; i<count; i++){
+				freeODL(&items[i].key);
+			}
+		}
+		free(items);
+		freeODL(&d);
+		fprintf(outODL, "Tried to sort values that can not be ordered");
+		abortODL();
+	}
+	for(size_t i=0; i<count; i++){
+		list->bottom[i]=items[i].value;
+		if(owned){
+			freeODL(&items[i].key);
+		}
+	}
+	free(items);
+	pushODL(stack, d);
+}
+
+/* sort list is the list in ascending order. */
+void sortODLB(ODLList * stack, ODLDictionary * dictionary){
+	ODLData d=popODL(stack);
+	ODLList * list=ownElementsODL(&d, dictionary, "sort");
+	size_t count=list->top-list->bottom;
+	ODLSortItem * items=malloc((count ? count : 1)*sizeof(ODLSortItem));
+	for(size_t i=0; i<count; i++){
+		items[i].key=list->bottom[i];
+		items[i].value=list->bottom[i];
+	}
+	finishSortODL(stack, d, items, 0);
+}
+
+/* The keys sort_by has worked out so far, for a hold while it evaluates the
+   rest. */
+typedef struct ODLKeysSoFar {
+	ODLSortItem * items;
+	size_t count;
+} ODLKeysSoFar;
+
+void releaseKeysODL(void * p){
+	ODLKeysSoFar * keys=p;
+	for(size_t i=0; i<keys->count; i++){
+		freeODL(&keys->items[i].key);
+	}
+	free(keys->items);
+}
+
+/* sort_by body list orders list by what body gives for each element,
+   evaluating it once per element. Elements with equal keys keep their
+   order. */
+void sortByODLB(ODLList * stack, ODLDictionary * dictionary){
+	ODLData body=popODL(stack);
+	ODLData d=popODL(stack);
+	ODLHold bodyHold;
+	holdValueODL(&bodyHold, &body);
+	ODLList * list=ownElementsODL(&d, dictionary, "sort_by");
+	size_t count=list->top-list->bottom;
+	ODLKeysSoFar keys;
+	keys.items=malloc((count ? count : 1)*sizeof(ODLSortItem));
+	keys.count=0;
+	ODLHold listHold, keysHold;
+	holdValueODL(&listHold, &d);
+	holdODL(&keysHold, &releaseKeysODL, &keys);
+	for(; keys.count<count; keys.count++){
+		keys.items[keys.count].key=applyODL(dictionary, copyODL(body), copyODL(list->bottom[keys.count]));
+		keys.items[keys.count].value=list->bottom[keys.count];
+	}
+	unholdODL(&keysHold);
+	unholdODL(&listHold);
+	unholdODL(&bodyHold);
+	freeODL(&body);
+	finishSortODL(stack, d, keys.items, 1);
+}
+
+/* binary_search list x is the index of the first element of the sorted list
+   equal to x, or -1 if there is none. */
+void binarySearchODLB(ODLList * stack, ODLDictionary * dictionary){
+	ODLData d=popODL(stack);
+	ODLData x=popODL(stack);
+	if(d.type!=ODL_LIST){
+		fprintf(outODL, "Tried to binary_search with non-list");
+		freeODL(&d);
+		freeODL(&x);
+		abortODL();
+	}
+	ODLList * list=d.value.list;
+	int kind=sortKindODL(&x);
+	size_t low=0;
+	size_t high=list->top-list->bottom;
+	while(low<high){
+		size_t middle=low+(high-low)/2;
+		if(kind==ODL_SORT_NONE || sortKindODL(list->bottom+middle)!=kind){
+			freeODL(&x);
+			freeListODL(list);
+			fprintf(outODL, "Tried to binary_search values that can not be ordered");
+			abortODL();
+		}
+		if(compareKeysODL(list->bottom+middle, &x)<0){
+			low=middle+1;
+		}else{
+			high=middle;
+		}
+	}
+	ODLData res;
+	res.type=ODL_INT;
+	res.value.integer=-1;
+	if(low<list->top-list->bottom && compareKeysODL(list->bottom+low, &x)==0){
+		res.value.integer=low;
+	}
+	freeODL(&x);
+	freeListODL(list);
+	pushODL(stack, res);
+}
+
+/* unique list drops each element equal, as = has it, to the one before it,
+   so a sorted list is left with one of each value. */
+void uniqueODLB(ODLList * stack, ODLDictionary * dictionary){
+	ODLData d=popODL(stack);
+	ODLList * list=ownElementsODL(&d, dictionary, "unique");
+	/* Slots left behind are marked, so the list can be freed whole if a
+	   comparison aborts. */
+	ODLHold hold;
+	holdValueODL(&hold, &d);
+	ODLData * kept=list->bottom;
+	for(ODLData * it=list->bottom; it<list->top; it++){
+		if(kept>list->bottom && checkEquality(kept-1, it)){
+			freeODL(it);
+			it->type=ODL_ERROR;
+			continue;
+		}
+		if(kept!=it){
+			*kept=*it;
+			it->type=ODL_ERROR;
+		}
+		kept++;
+	}
+	unholdODL(&hold);
+	list->top=kept;
+	pushODL(stack, d);
+
+}
+
+/* Maps. Each node of the trie takes 5 bits of the key's 64 bit hash and
+   holds, in slot order, the entries whose bits are in dataMap and the child
+   nodes whose bits are in nodeMap. Keys whose hashes are equal all the way
+   down share a collision node, which is searched in order. A node always
+   has at least two entries below it apart from the root, so a remove
+   leaving one pulls it up into the parent.
+
+   Every operation takes over the caller's reference to the node it is given
+   and returns a reference to the node to use instead. A node nothing else
+   refers to is changed in place, so inserting into a map that is not shared
+   only reallocates the node the key lands in.
+
+   Keys are numbers, strings, words and symbols, compared by type and value,
+   so 1 and 1.0 are different keys; a word and a symbol of the same name are
+   the same key, as with =. */
+struct ODLHamtNode {
+	size_t refs;
+	uint32_t dataMap;
+	uint32_t nodeMap;
+	uint32_t pairCount;
+	uint32_t nodeCount;
+	char collision;
+	ODLData * pairs;
+	ODLHamtNode ** nodes;
+};
+
+#define ODL_HAMT_BITS 5
+
+uint64_t hashODL(char * data, size_t length);
+
+uint64_t mixHashODL(uint64_t h){
+	h^=h>>33;
+	h*=UINT64_C(0xff51afd7ed558ccd);
+	h^=h>>33;
+	h*=UINT64_C(0xc4ceb9fe1a85ec53);
+	h^=h>>33;
+	return h;
+}
+
+char isMapKeyODL(ODLData * key){
+	return key->type==ODL_INT || key->type==ODL_NUM || key->type==ODL_BIGINT
+		|| key->type==ODL_STRING || key->type==ODL_WORD || key->type==ODL_SYMBOL;
+}
+
+/* Words hash by name rather than address, so maps list their keys in the
+   same order from one run to the next. */
+uint64_t hashKeyODL(ODLData * key){
+	switch(key->type){
+		case ODL_INT:
+			return mixHashODL(key->value.integer);
+		case ODL_NUM:{
+			ODLNum num=key->value.num==0 ? 0 : key->value.num;
+			uint64_t bits;
+			memcpy(&bits, &num, sizeof(bits));
+			return mixHashODL(bits ^ UINT64_C(0x9e3779b97f4a7c15));
+		}
+		case ODL_BIGINT:
+			return mixHashODL(hashODL((char *)key->value.bigint->limbs, key->value.bigint->count*sizeof(uint32_t))+key->value.bigint->negative);
+		case ODL_STRING:
+			return mixHashODL(hashODL(key->value.string->text, key->value.string->length));
+		default:
+			return mixHashODL(hashODL(key->value.word, strlen(key->value.word)));
+	}
+}
+
+char keysEqualODL(ODLData * a, ODLData * b){
+	if(a->type==ODL_WORD || a->type==ODL_SYMBOL){
+		return (b->type==ODL_WORD || b->type==ODL_SYMBOL) && a->value.word==b->value.word;
+	}
+	if(a->type!=b->type){
+		return 0;
+	}
+	if(a->type==ODL_NUM){
+		return a->value.num==b->value.num;
+	}
+	return checkEquality(a, b);
+}
+
+size_t nodeBytesODL(uint32_t pairs, uint32_t nodes){
+	return sizeof(ODLHamtNode)+2*pairs*sizeof(ODLData)+nodes*sizeof(ODLHamtNode *);
+}
+
+ODLHamtNode * allocNodeODL(uint32_t pairs, uint32_t nodes){
+	size_t bytes=nodeBytesODL(pairs, nodes);
+	reserveODL(bytes);
+	ODLHamtNode * node=malloc(bytes);
+	node->refs=1;
+	node->dataMap=0;
+	node->nodeMap=0;
+	node->pairCount=pairs;
+	node->nodeCount=nodes;
+	node->collision=0;
+	node->pairs=(ODLData *)(node+1);
+	node->nodes=(ODLHamtNode **)(node->pairs+2*pairs);
+	return node;
+}
+
+void releaseNodeODL(ODLHamtNode * node){
+	if(releaseRefODL(&node->refs)>0){
+		return;
+	}
+	for(uint32_t i=0; i<2*node->pairCount; i++){
+		freeODL(node->pairs+i);
+	}
+	for(uint32_t i=0; i<node->nodeCount; i++){
+		releaseNodeODL(node->nodes[i]);
+	}
+	memoryODL.bytes-=nodeBytesODL(node->pairCount, node->nodeCount);
+	free(node);
+}
+
+/* Fills node, which has room for them, with the entries of from apart from
+   pair skipPair and child skipNode, leaving a gap at pair gapPair and child
+   gapNode. Pass -1 for any that do not apply. The caller's reference to from
+   is dropped. */
+void refillNodeODL(ODLHamtNode * node, ODLHamtNode * from, int skipPair, int gapPair, int skipNode, int gapNode){
+	uint32_t to=0;
+	for(uint32_t i=0; i<from->pairCount; i++){
+		if(to==gapPair){
+			to++;
+		}
+		if(i==skipPair){
+			continue;
+		}
+		node->pairs[2*to]=copyODL(from->pairs[2*i]);
+		node->pairs[2*to+1]=copyODL(from->pairs[2*i+1]);
+		to++;
+	}
+	to=0;
+	for(uint32_t i=0; i<from->nodeCount; i++){
+		if(to==gapNode){
+			to++;
+		}
+		if(i==skipNode){
+			continue;
+		}
+		node->nodes[to]=from->nodes[i];
+		retainODL(&node->nodes[to]->refs);
+		to++;
+	}
+	releaseNodeODL(from);
+}
+
+/* node, copied first if it is shared, so it can be changed in place. */
+ODLHamtNode * editableNodeODL(ODLHamtNode * node){
+	if(node->refs==1){
+		return node;
+	}
+	ODLHamtNode * copy=allocNodeODL(node->pairCount, node->nodeCount);
+	copy->dataMap=node->dataMap;
+	copy->nodeMap=node->nodeMap;
+	copy->collision=node->collision;
+	refillNodeODL(copy, node, -1, -1, -1, -1);
+	return copy;
+}
+
+uint32_t slotODL(uint32_t map, uint32_t bit){
+	return __builtin_popcount(map & (bit-1));
+}
+
+/* A node holding the two entries, whose keys differ but whose hashes agree
+   below shift. */
+ODLHamtNode * joinPairsODL(ODLData k1, ODLData v1, uint64_t h1, ODLData k2, ODLData v2, uint64_t h2, int shift){
+	if(shift>=64){
+		ODLHamtNode * node=allocNodeODL(2, 0);
+		node->collision=1;
+		node->pairs[0]=k1;
+		node->pairs[1]=v1;
+		node->pairs[2]=k2;
+		node->pairs[3]=v2;
+		return node;
+	}
+	uint32_t b1=1u<<((h1>>shift) & 31);
+	uint32_t b2=1u<<((h2>>shift) & 31);
+	if(b1==b2){
+		ODLHamtNode * node=allocNodeODL(0, 1);
+		node->nodeMap=b1;
+		node->nodes[0]=joinPairsODL(k1, v1, h1, k2, v2, h2, shift+ODL_HAMT_BITS);
+		return node;
+	}
+	ODLHamtNode * node=allocNodeODL(2, 0);
+	node->dataMap=b1 | b2;
+	int first=b1<b2 ? 0 : 2;
+	node->pairs[first]=k1;
+	node->pairs[first+1]=v1;
+	node->pairs[2-first]=k2;
+	node->pairs[3-first]=v2;
+	return node;
+}
+
+/* Sets key to value, taking over both. *added is set if key was not there. */
+ODLHamtNode * hamtInsertODL(ODLHamtNode * node, ODLData key, ODLData value, uint64_t hash, int shift, char * added){
+	if(node->collision){
+		for(uint32_t i=0; i<node->pairCount; i++){
+			if(keysEqualODL(node->pairs+2*i, &key)){
+				node=editableNodeODL(node);
+				freeODL(&key);
+				freeODL(node->pairs+2*i+1);
+				node->pairs[2*i+1]=value;
+				return node;
+			}
+		}
+		ODLHamtNode * grown=allocNodeODL(node->pairCount+1, 0);
+		grown->collision=1;
+		grown->pairs[2*node->pairCount]=key;
+		grown->pairs[2*node->pairCount+1]=value;
+		refillNodeODL(grown, node, -1, -1, -1, -1);
+		*added=1;
+		return grown;
+	}
+
+	uint32_t bit=1u<<((hash>>shift) & 31);
+	if(node->nodeMap & bit){
+		uint32_t j=slotODL(node->nodeMap, bit);
+		node=editableNodeODL(node);
+		node->nodes[j]=hamtInsertODL(node->nodes[j], key, value, hash, shift+ODL_HAMT_BITS, added);
+		return node;
+	}
+	uint32_t i=slotODL(node->dataMap, bit);
+	if(!(node->dataMap & bit)){
+		ODLHamtNode * grown=allocNodeODL(node->pairCount+1, node->nodeCount);
+		grown->dataMap=node->dataMap | bit;
+		grown->nodeMap=node->nodeMap;
+		grown->pairs[2*i]=key;
+		grown->pairs[2*i+1]=value;
+		refillNodeODL(grown, node, -1, i, -1, -1);
+		*added=1;
+		return grown;
+	}
+	if(keysEqualODL(node->pairs+2*i, &key)){
+		node=editableNodeODL(node);
+		freeODL(&key);
+		freeODL(node->pairs+2*i+1);
+		node->pairs[2*i+1]=value;
+		return node;
+	}
+
+	ODLData * old=node->pairs+2*i;
+	ODLHamtNode * child=joinPairsODL(copyODL(old[0]), copyODL(old[1]), hashKeyODL(old), key, value, hash, shift+ODL_HAMT_BITS);
+	uint32_t j=slotODL(node->nodeMap, bit);
+	ODLHamtNode * split=allocNodeODL(node->pairCount-1, node->nodeCount+1);
+	split->dataMap=node->dataMap & ~bit;
+	split->nodeMap=node->nodeMap | bit;
+	split->nodes[j]=child;
+	refillNodeODL(split, node, i, -1, -1, j);
+	*added=1;
+	return split;
+}
+
+/* Removes key if it is there, setting *removed. */
+ODLHamtNode * hamtRemoveODL(ODLHamtNode * node, ODLData * key, uint64_t hash, int shift, char * removed){
+	if(node->collision){
+		for(uint32_t i=0; i<node->pairCount; i++){
+			if(keysEqualODL(node->pairs+2*i, key)){
+				ODLHamtNode * shrunk=allocNodeODL(node->pairCount-1, 0);
+				shrunk->collision=1;
+				refillNodeODL(shrunk, node, i, -1, -1, -1);
+				*removed=1;
+				return shrunk;
+			}
+		}
+		return node;
+	}
+
+	uint32_t bit=1u<<((hash>>shift) & 31);
+	if(node->dataMap & bit){
+		uint32_t i=slotODL(node->dataMap, bit);
+		if(!keysEqualODL(node->pairs+2*i, key)){
+			return node;
+		}
+		ODLHamtNode * shrunk=allocNodeODL(node->pairCount-1, node->nodeCount);
+		shrunk->dataMap=node->dataMap & ~bit;
+		shrunk->nodeMap=node->nodeMap;
+		refillNodeODL(shrunk, node, i, -1, -1, -1);
+		*removed=1;
+		return shrunk;
+	}
+	if(!(node->nodeMap & bit)){
+		return node;
+	}
+
+	uint32_t j=slotODL(node->nodeMap, bit);
+	ODLHamtNode * child=node->nodes[j];
+	retainODL(&child->refs);
+	child=hamtRemoveODL(child, key, hash, shift+ODL_HAMT_BITS, removed);
+	if(!*removed){
+		releaseNodeODL(child);
+		return node;
+	}
+	if(child->pairCount==1 && child->nodeCount==0){
+		uint32_t i=slotODL(node->dataMap, bit);
+		ODLHamtNode * merged=allocNodeODL(node->pairCount+1, node->nodeCount-1);
+		merged->dataMap=node->dataMap | bit;
+		merged->nodeMap=node->nodeMap & ~bit;
+		merged->pairs[2*i]=copyODL(child->pairs[0]);
+		merged->pairs[2*i+1]=copyODL(child->pairs[1]);
+		releaseNodeODL(child);
+		refillNodeODL(merged, node, -1, i, j, -1);
+		return merged;
+	}
+	node=editableNodeODL(node);
+	releaseNodeODL(node->nodes[j]);
+	node->nodes[j]=child;
+	return node;
+}
+
+ODLData * hamtFindODL(ODLHamtNode * node, ODLData * key, uint64_t hash){
+	for(int shift=0; !node->collision; shift+=ODL_HAMT_BITS){
+		uint32_t bit=1u<<((hash>>shift) & 31);
+		if(node->dataMap & bit){
+			ODLData * pair=node->pairs+2*slotODL(node->dataMap, bit);
+			return keysEqualODL(pair, key) ? pair+1 : NULL;
+		}
+		if(!(node->nodeMap & bit)){
+			return NULL;
+		}
+		node=node->nodes[slotODL(node->nodeMap, bit)];
+	}
+	for(uint32_t i=0; i<node->pairCount; i++){
+		if(keysEqualODL(node->pairs+2*i, key)){
+			return node->pairs+2*i+1;
+		}
+	}
+	return NULL;
+}
+
+ODLObject allocObjectODL(ODLHamtNode * root, size_t size){
+	reserveODL(sizeof(Object));
+	ODLObject object=malloc(sizeof(Object));
+	object->refs=1;
+	object->size=size;
+	object->root=root;
+	return object;
+}
+
+void freeObjectODL(ODLObject object){
+	if(releaseRefODL(&object->refs)>0){
+		return;
+	}
+	releaseNodeODL(object->root);
+	memoryODL.bytes-=sizeof(Object);
+	free(object);
+}
+
+/* Makes the map held by d safe to change, giving it an object of its own
+   if it is shared. The trie stays shared until a node in it is changed. */
+ODLObject ownObjectODL(ODLData * d){
+	ODLObject old=d->value.object;
+	if(old->refs==1){
+		return old;
+	}
+	retainODL(&old->root->refs);
+	ODLObject object=allocObjectODL(old->root, old->size);
+	freeObjectODL(old);
+	d->value.object=object;
+	return object;
+}
+
+void insertIntoObjectODL(ODLObject object, ODLData key, ODLData value){
+	char added=0;
+	object->root=hamtInsertODL(object->root, key, value, hashKeyODL(&key), 0, &added);
+	object->size+=added;
+}
+
+void dumpNodeODL(ODLBuffer * buffer, ODLHamtNode * node, int indent){
+	for(uint32_t i=0; i<node->pairCount; i++){
+		dumpValueODL(buffer, node->pairs[2*i], indent);
+		dumpValueODL(buffer, node->pairs[2*i+1], indent+1);
+	}
+	for(uint32_t i=0; i<node->nodeCount; i++){
+		dumpNodeODL(buffer, node->nodes[i], indent);
+	}
+}
+
+/* Each key is followed by its value, indented one further. */
+void dumpObjectODL(ODLBuffer * buffer, ODLObject object, int indent){
+	appendTextODL(buffer, "Object: ");
+	appendIntODL(buffer, object->size);
+	appendODL(buffer, "\n", 1);
+	dumpNodeODL(buffer, object->root, indent+1);
+}
+
+/* Calls each with every key and value in the trie, in trie order. */
+void eachPairODL(ODLHamtNode * node, void (*each)(ODLData * pair, void * context), void * context){
+	for(uint32_t i=0; i<node->pairCount; i++){
+		each(node->pairs+2*i, context);
+	}
+	for(uint32_t i=0; i<node->nodeCount; i++){
+		eachPairODL(node->nodes[i], each, context);
+	}
+}
+
+/* Frees map and key before aborting if key can not be a key. */
+void checkMapKeyODL(ODLData * map, ODLData * key, char * name){
+	if(!isMapKeyODL(key)){
+		fprintf(outODL, "Tried to %s with a key that is not a number, string or symbol", name);
+		freeODL(map);
+		freeODL(key);
+		abortODL();
+	}
+}
+
+ODLData popObjectODL(ODLList * stack, char * name){
+	ODLData d=popODL(stack);
+	if(d.type!=ODL_OBJECT){
+		fprintf(outODL, "Tried to %s with non-object", name);
+		freeODL(&d);
+		abortODL();
+	}
+	return d;
+}
+
+/* new_map is an empty map. */
+void newMapODLB(ODLList * stack, ODLDictionary * dictionary){
+	ODLData d;
+	d.type=ODL_OBJECT;
+	d.value.object=allocObjectODL(allocNodeODL(0, 0), 0);
+	pushODL(stack, d);
+}
+
+/* insert map key value is map with key set to value. */
+void insertODLB(ODLList * stack, ODLDictionary * dictionary){
+	ODLData d=popObjectODL(stack, "insert");
+	ODLData key=popODL(stack);
+	checkMapKeyODL(&d, &key, "insert");
+	ODLData value=popODL(stack);
+	insertIntoObjectODL(ownObjectODL(&d), key, value);
+	pushODL(stack, d);
+}
+
+/* lookup map key is the value of key, which must be in map. */
+void lookupODLB(ODLList * stack, ODLDictionary * dictionary){
+	ODLData d=popObjectODL(stack, "lookup");
+	ODLData key=popODL(stack);
+	checkMapKeyODL(&d, &key, "lookup");
+	ODLData * value=hamtFindODL(d.value.object->root, &key, hashKeyODL(&key));
+	if(value==NULL){
+		fprintf(outODL, "Tried to lookup a key that is not in the map");
+		freeODL(&key);
+		freeODL(&d);
+		abortODL();
+	}
+	ODLData res=copyODL(*value);
+	freeODL(&key);
+	freeODL(&d);
+	pushODL(stack, res);
+}
+
+/* has map key is 1 if key is in map and 0 if not. */
+void hasODLB(ODLList * stack, ODLDictionary * dictionary){
+	ODLData d=popObjectODL(stack, "has");
+	ODLData key=popODL(stack);
+	ODLData res;
+	res.type=ODL_INT;
+	res.value.integer=isMapKeyODL(&key) && hamtFindODL(d.value.object->root, &key, hashKeyODL(&key))!=NULL;
+	freeODL(&key);
+	freeODL(&d);
+	pushODL(stack, res);
+}
+
+/* remove map key is map without key, which need not be in it. */
+void removeODLB(ODLList * stack, ODLDictionary * dictionary){
+	ODLData d=popObjectODL(stack, "remove");
+	ODLData key=popODL(stack);
+	checkMapKeyODL(&d, &key, "remove");
+	uint64_t hash=hashKeyODL(&key);
+	if(hamtFindODL(d.value.object->root, &key, hash)!=NULL){
+		ODLObject object=ownObjectODL(&d);
+		char removed=0;
+		object->root=hamtRemoveODL(object->root, &key, hash, 0, &removed);
+		object->size-=removed;
+	}
+	freeODL(&key);
+	pushODL(stack, d);
+}
+
+void collectKeyODL(ODLData * pair, void * context){
+	pushODL(context, copyODL(pair[0]));
+}
+
+/* keys map is a list of the keys of map, in no particular order. */
+void keysODLB(ODLList * stack, ODLDictionary * dictionary){
+	ODLData d=popObjectODL(stack, "keys");
+	ODLData res;
+	res.type=ODL_LIST;
+	res.value.list=allocList(d.value.object->size ? d.value.object->size : 1);
+	eachPairODL(d.value.object->root, &collectKeyODL, res.value.list);
+	freeODL(&d);
+	pushODL(stack, res);
+}
+
+void insertPairODL(ODLData * pair, void * context){
+	insertIntoObjectODL(context, copyODL(pair[0]), copyODL(pair[1]));
+}
+
+/* Used by merge: the entries of from are set in the map held by into, so
+   from wins where both have a key. */
+void mergeObjectsODL(ODLData * into, ODLData * from){
+	if(into->value.object->size==0){
+		freeODL(into);
+		*into=copyODL(*from);
+		return;
+	}
+	eachPairODL(from->value.object->root, &insertPairODL, ownObjectODL(into));
+}
+
+void genericLogicalODLB(ODLList * stack, ODLDictionary * dictionary, intArithmeticCB iCb){
+	ODLData first=popODL(stack);
+	if(first.type!=ODL_INT){
+		fprintf(outODL, "Tried logical operator with non-int");
+		freeODL(&first);
+		abortODL();
+	}
+	
+	ODLData second=popODL(stack);
+	if(second.type!=ODL_INT){
+		fprintf(outODL, "Tried logical operator with non-int");
+		freeODL(&second);
+		abortODL();
+	}
+
+
+	ODLData d;
+	d.type=ODL_INT;	
+	d.value.integer=iCb(first.value.integer, second.value.integer);
+
+	pushODL(stack, d);
+}
+
+int andLog(ODLInt a, ODLInt b){
+	return (a && b);
+}
+
+void andODLB(ODLList * stack, ODLDictionary * dictionary){
+	genericLogicalODLB(stack, dictionary, &andLog);
+}
+
+int orLog(ODLInt a, ODLInt b){
+	return (a || b);
+}
+
+void orODLB(ODLList * stack, ODLDictionary * dictionary){
+	genericLogicalODLB(stack, dictionary, &orLog);
+}
+
+void lazyLogicalResultODLB(ODLList * stack, ODLDictionary * dictionary){
+	ODLData * cur=stack->top-1;
+	if(cur->type!=ODL_INT){
+		fprintf(outODL, "Tried logical operator with non-int");
+		abortODL();
+	}
+	cur->value.integer=cur->value.integer!=0;
+}
+
+/* lazy_and a b and lazy_or a b only evaluate b when a does not already
+   decide the result. Where the extent of b can not be told they are and and
+   or. */
+void lazyLogicalODLB(ODLList * stack, ODLDictionary * dictionary, char decides){
+	ODLData first=popODL(stack);
+	if(first.type!=ODL_INT){
+		fprintf(outODL, "Tried logical operator with non-int");
+		freeODL(&first);
+		abortODL();
+	}
+	size_t extent=expressionExtentODL(stack, stack->top, dictionary);
+	if(extent==0){
+		pushODL(stack, first);
+		pushFrameODL(dictionary, decides ? &orODLB : &andODLB, 2);
+		return;
+	}
+	if((first.value.integer!=0)==decides){
+		keepTokensODL(stack, stack->top-extent, stack->top, 0);
+		first.value.integer=decides;
+		pushODL(stack, first);
+		return;
+	}
+	pushFrameODL(dictionary, &lazyLogicalResultODLB, 1);
+}
+
+void lazyAndODLB(ODLList * stack, ODLDictionary * dictionary){
+	lazyLogicalODLB(stack, dictionary, 0);
+}
+
+void lazyOrODLB(ODLList * stack, ODLDictionary * dictionary){
+	lazyLogicalODLB(stack, dictionary, 1);
+}
+
+int xorLog(ODLInt a, ODLInt b){
+	return (!a != !b);
+}
+
+void xorODLB(ODLList * stack, ODLDictionary * dictionary){
+	genericLogicalODLB(stack, dictionary, &xorLog);
+}
+
+void dumpODLB(ODLList * stack, ODLDictionary * dictionary){
+	fprintf(outODL, "Start Dump");
+	dumpODLr(stack, 0, 1);
+	fprintf(outODL, "\n");
+}
+
+void memStatsODLB(ODLList * stack, ODLDictionary * dictionary){
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	double seconds=(now.tv_sec-memoryODL.start.tv_sec)+(now.tv_nsec-memoryODL.start.tv_nsec)/1e9;
+	fprintf(outODL, "Memory: %zu lists, %zu bytes, peak %zu bytes, %zu allocations (%.0f/s)\n",
+		memoryODL.lists, memoryODL.bytes, memoryODL.peak, memoryODL.allocations,
+		seconds>0 ? memoryODL.allocations/seconds : 0);
+}
+
+/* bench count body runs body count times after a warm-up of a tenth as many,
+   so definitions it calls have been compiled before timing starts, and
+   reports the time and allocations per run. The hardware counters come from
+   perf_event_open and are left out where it is not allowed. */
+#define ODL_BENCH_MARK ((ODLDataType)-1)
+
+typedef struct ODLCounters {
+	int fds[4];
+	int count;
+} ODLCounters;
+
+void openCountersODL(ODLCounters * counters){
+	static const uint64_t configs[4]={
+		PERF_COUNT_HW_INSTRUCTIONS,
+		PERF_COUNT_HW_CPU_CYCLES,
+		PERF_COUNT_HW_CACHE_MISSES,
+		PERF_COUNT_HW_BRANCH_MISSES,
+	};
+	counters->count=0;
+	for(int i=0; i<4; i++){
+		struct perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.type=PERF_TYPE_HARDWARE;
+		attr.size=sizeof(attr);
+		attr.config=configs[i];
+		attr.disabled=i==0;
+		attr.exclude_kernel=1;
+		attr.exclude_hv=1;
+		attr.read_format=PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+		int fd=syscall(SYS_perf_event_open, &attr, 0, -1, i==0 ? -1 : counters->fds[0], 0);
+		if(fd<0){
+			while(counters->count>0){
+				close(counters->fds[--counters->count]);
+			}
+			return;
+		}
+		counters->fds[counters->count++]=fd;
+	}
+}
+
+void closeCountersODL(ODLCounters * counters){
+	while(counters->count>0){
+		close(counters->fds[--counters->count]);
+	}
+}
+
+/* Evaluates body the way a line is evaluated and drops what it leaves. */
+void benchRunODL(ODLList * stack, ODLDictionary * dictionary, ODLData body){
+	pushODL(stack, copyODL(body));
+	unrollODL(stack, dictionary);
+	executeODL(stack, dictionary);
+	while(stack->top>stack->bottom){
+		ODLData d=popODL(stack);
+		freeODL(&d);
+		executeODL(stack, dictionary);
+	}
+}
+
+/* The most slots of stack one run of body uses, found by marking every slot
+   beforehand and looking for the highest one overwritten, so the runs being
+   timed carry no bookkeeping. Runs again if the stack had to grow. */
+size_t benchDepthODL(ODLList * stack, ODLDictionary * dictionary, ODLData body){
+	while(1){
+		size_t alloc=stack->alloc;
+		for(size_t i=0; i<alloc; i++){
+			stack->base[i].type=ODL_BENCH_MARK;
+		}
+		benchRunODL(stack, dictionary, body);
+		if(stack->alloc==alloc){
+			while(alloc>0 && stack->base[alloc-1].type==ODL_BENCH_MARK){
+				alloc--;
+			}
+			return alloc;
+		}
+	}
+}
+
+void benchODLB(ODLList * stack, ODLDictionary * dictionary){
+	ODLData count=popODL(stack);
+	ODLData body=popODL(stack);
+	if(count.type!=ODL_INT || count.value.integer<=0){
+		fprintf(outODL, "Tried to bench with a non-positive count");
+		freeODL(&count);
+		freeODL(&body);
+		abortODL();
+
+	}
+	size_t runs=count.value.integer;
+
+	ODLList * runStack=allocList(64);
+	ODLCounters counters;
+	openCountersODL(&counters);
+
+	jmp_buf * outer=recoverODL;
+	ODLHold * outerFloor=holdFloorODL;
+	jmp_buf recover;
+	if(setjmp(recover)!=0){
+		recoverODL=outer;
+		holdFloorODL=outerFloor;
+		closeCountersODL(&counters);
+		freeListODL(runStack);
+		freeODL(&body);
+		abortODL();
+	}
+	recoverODL=&recover;
+	holdFloorODL=holdsODL;
+
+	for(size_t i=0; i<runs/10+1; i++){
+		benchRunODL(runStack, dictionary, body);
+	}
+
+	if(counters.count>0){
+		ioctl(counters.fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+		ioctl(counters.fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+	}
+	size_t allocations=memoryODL.allocations;
+	size_t made=memoryODL.made;
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(size_t i=0; i<runs; i++){
+		benchRunODL(runStack, dictionary, body);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	allocations=memoryODL.allocations-allocations;
+	made=memoryODL.made-made;
+	uint64_t values[3+4]={0};
+	if(counters.count>0){
+		ioctl(counters.fds[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+		if(read(counters.fds[0], values, sizeof(values))!=sizeof(values)){
+			closeCountersODL(&counters);
+		}
+	}
+
+	size_t depth=benchDepthODL(runStack, dictionary, body);
+	recoverODL=outer;
+	holdFloorODL=outerFloor;
+
+	double ns=(end.tv_sec-start.tv_sec)*1e9+(end.tv_nsec-start.tv_nsec);
+	fprintf(outODL, "Bench: %zu runs, %.1f ns/run, %.2f allocations/run, %.2f lists made/run, stack high-water %zu\n",
+		runs, ns/runs, (double)allocations/runs, (double)made/runs, depth);
+	if(counters.count>0){
+		/* Scaled up for the time the group was not scheduled on the PMU. */
+		double scale=values[2]>0 ? (double)values[1]/values[2] : 1;
+		fprintf(outODL, "Counters: %.1f instructions, %.1f cycles, %.2f cache misses, %.2f branch misses per run\n",
+			values[3]*scale/runs, values[4]*scale/runs, values[5]*scale/runs, values[6]*scale/runs);
+	}else{
+		fprintf(outODL, "Counters: unavailable\n");
+	}
+
+	closeCountersODL(&counters);
+	freeListODL(runStack);
+	freeODL(&body);
+}
+
+/* Template JIT. Once a list definition has been called jitThreshold times it
+   is flattened, splicing in the bodies of any definitions it names, and if the
+   result is a single prefix expression of integer literals and the builtins in
+   jitOps it is compiled to x86-64. Operands missing from the end of the body
+   are taken from the stack as usual. The generated code guards that those
+   operands are ints and that nothing overflows, and the dictionary entries it
+   was built from are checked before each call. Any guard failing falls back to
+   the interpreter. */
+
+#define ODL_JIT_MAX_TOKENS 256
+#define ODL_JIT_MAX_HOLES 16
+#define ODL_JIT_MAX_DEPS 32
+#define ODL_JIT_MAX_DEPTH 16
+
+#if defined(__x86_64__)
+char jitEnabled=1;
+#else
+char jitEnabled=0;
+#endif
+size_t jitThreshold=100;
+
+typedef enum ODLJitOp {
+	ODL_JIT_LITERAL,
+	ODL_JIT_HOLE,
+	ODL_JIT_ADD,
+	ODL_JIT_MINUS,
+	ODL_JIT_MULTIPLY,
+	ODL_JIT_LESS_THAN,
+	ODL_JIT_LESS_THAN_EQUAL,
+	ODL_JIT_GREATER_THAN,
+	ODL_JIT_GREATER_THAN_EQUAL,
+	ODL_JIT_EQUAL,
+	ODL_JIT_AND,
+	ODL_JIT_OR,
+	ODL_JIT_XOR,
+} ODLJitOp;
+
+typedef struct ODLJitBuiltin {
+	ODLBuiltin builtin;
+	ODLJitOp op;
+} ODLJitBuiltin;
+
+ODLJitBuiltin jitOps[]={
+	{&addODLB, ODL_JIT_ADD},
+	{&minusODLB, ODL_JIT_MINUS},
+	{&multiplyODLB, ODL_JIT_MULTIPLY},
+	{&lessThanODLB, ODL_JIT_LESS_THAN},
+	{&lessThanEqualODLB, ODL_JIT_LESS_THAN_EQUAL},
+	{&greaterThanODLB, ODL_JIT_GREATER_THAN},
+	{&greaterThanEqualODLB, ODL_JIT_GREATER_THAN_EQUAL},
+	{&equalODLB, ODL_JIT_EQUAL},
+	{&andODLB, ODL_JIT_AND},
+	{&orODLB, ODL_JIT_OR},
+	{&xorODLB, ODL_JIT_XOR},
+};
+
+typedef char (*ODLJitFunction)(ODLData * top, ODLInt * result);
+
+typedef struct ODLJitDep {
+	size_t index;
+	size_t version;
+} ODLJitDep;
+
+typedef struct ODLJitCode {
+	ODLJitFunction function;
+	size_t refs;
+	size_t size;
+	int holes;
+	int depCount;
+	ODLJitDep deps[ODL_JIT_MAX_DEPS];
+} ODLJitCode;
+
+typedef struct ODLJitCursor {
+	ODLData * it;
+	ODLData * end;
+} ODLJitCursor;
+
+typedef struct ODLJitCompiler {
+	ODLDictionary * dictionary;
+	ODLJitCursor cursors[ODL_JIT_MAX_DEPTH];
+	int depth;
+	int tokens;
+	int operators;
+	char failed;
+	unsigned char * code;
+	size_t length;
+	size_t alloc;
+	size_t deopts[ODL_JIT_MAX_TOKENS];
+	int deoptCount;
+	ODLJitCode * jit;
+} ODLJitCompiler;
+
+void emitJit(ODLJitCompiler * c, const unsigned char * bytes, size_t count){
+	if(c->length+count>c->alloc){
+		c->alloc=(c->length+count)*2;
+		c->code=realloc(c->code, c->alloc);
+	}
+	memcpy(c->code+c->length, bytes, count);
+	c->length+=count;
+}
+
+void emitJit32(ODLJitCompiler * c, uint32_t v){
+	emitJit(c, (unsigned char *)&v, 4);
+}
+
+void emitJitDeopt(ODLJitCompiler * c, unsigned char condition){
+	unsigned char jump[]={0x0f, condition};
+	emitJit(c, jump, 2);
+	c->deopts[c->deoptCount++]=c->length;
+	emitJit32(c, 0);
+}
+
+void addJitDep(ODLJitCompiler * c, ODLDefStack * entry){
+	ODLJitCode * jit=c->jit;
+	size_t index=entry->position;
+	for(int i=0; i<jit->depCount; i++){
+		if(jit->deps[i].index==index){
+			return;
+		}
+	}
+	if(jit->depCount>=ODL_JIT_MAX_DEPS){
+		c->failed=1;
+		return;
+	}
+	jit->deps[jit->depCount].index=index;
+	jit->deps[jit->depCount].version=entry->version;
+	jit->depCount++;
+}
+
+/* Returns the next token of the flattened definition, or NULL once the body
+   is used up and the remaining operands have to come from the stack. */
+ODLData * nextJitToken(ODLJitCompiler * c){
+	while(c->depth>0){
+		ODLJitCursor * cursor=c->cursors+c->depth-1;
+		if(cursor->it==cursor->end){
+			c->depth--;
+			continue;
+		}
+		ODLData * token=cursor->it++;
+		if(++c->tokens>ODL_JIT_MAX_TOKENS){
+			c->failed=1;
+			return NULL;
+		}
+		if(token->type!=ODL_WORD){
+			return token;
+		}
+		ODLDefStack * entry=findEntryInDictionary(c->dictionary, token->value.word);
+		if(entry==NULL || entry->code->top==entry->code->bottom){
+			c->failed=1;
+			return NULL;
+		}
+		addJitDep(c, entry);
+		ODLData * def=entry->code->top-1;
+		if(def->type!=ODL_LIST){
+			return def;
+		}
+		if(c->depth>=ODL_JIT_MAX_DEPTH){
+			c->failed=1;
+			return NULL;
+		}
+		c->cursors[c->depth].it=def->value.list->bottom;
+		c->cursors[c->depth].end=def->value.list->top;
+		c->depth++;
+	}
+	return NULL;
+}
+
+void compileJitExpression(ODLJitCompiler * c){
+	if(c->failed){
+		return;
+	}
+	ODLData * token=nextJitToken(c);
+	if(c->failed){
+		return;
+	}
+	if(token==NULL){
+		int hole=c->jit->holes++;
+		if(hole>=ODL_JIT_MAX_HOLES){
+			c->failed=1;
+			return;
+		}
+		/* The operands sit just below rdi, the first one topmost.
+		   cmp dword [rdi+type], ODL_INT; jne deopt; push qword [rdi+value] */
+		unsigned char check[]={0x81, 0xbf};
+		emitJit(c, check, 2);
+		emitJit32(c, -(hole+1)*(int32_t)sizeof(ODLData)+offsetof(ODLData, type));
+		emitJit32(c, ODL_INT);
+		emitJitDeopt(c, 0x85);
+		unsigned char load[]={0xff, 0xb7};
+		emitJit(c, load, 2);
+		emitJit32(c, -(hole+1)*(int32_t)sizeof(ODLData)+offsetof(ODLData, value));
+		return;
+	}
+	if(token->type==ODL_INT){
+		/* mov rax, imm64; push rax */
+		unsigned char load[]={0x48, 0xb8};
+		emitJit(c, load, 2);
+		emitJit(c, (unsigned char *)&token->value.integer, 8);
+		unsigned char push[]={0x50};
+		emitJit(c, push, 1);
+		return;
+	}
+	ODLJitOp op=ODL_JIT_LITERAL;
+	if(token->type==ODL_BUILTIN){
+		for(int i=0; i<sizeof(jitOps)/sizeof(ODLJitBuiltin); i++){
+			if(jitOps[i].builtin==token->value.builtin->call){
+				op=jitOps[i].op;
+			}
+		}
+	}
+	if(op==ODL_JIT_LITERAL){
+		c->failed=1;
+		return;
+	}
+	c->operators++;
+
+	compileJitExpression(c);
+	compileJitExpression(c);
+
+	/* pop rcx; pop rax */
+	unsigned char operands[]={0x59, 0x58};
+	emitJit(c, operands, 2);
+	unsigned char setcc=0;
+	switch(op){
+		case ODL_JIT_ADD:{
+			unsigned char add[]={0x48, 0x01, 0xc8};
+			emitJit(c, add, 3);
+			emitJitDeopt(c, 0x80);
+		}break;
+		case ODL_JIT_MINUS:{
+			unsigned char sub[]={0x48, 0x29, 0xc8};
+			emitJit(c, sub, 3);
+			emitJitDeopt(c, 0x80);
+		}break;
+		case ODL_JIT_MULTIPLY:{
+			unsigned char mul[]={0x48, 0x0f, 0xaf, 0xc1};
+			emitJit(c, mul, 4);
+			emitJitDeopt(c, 0x80);
+		}break;
+		case ODL_JIT_LESS_THAN: setcc=0x9c; break;
+		case ODL_JIT_LESS_THAN_EQUAL: setcc=0x9e; break;
+		case ODL_JIT_GREATER_THAN: setcc=0x9f; break;
+		case ODL_JIT_GREATER_THAN_EQUAL: setcc=0x9d; break;
+		case ODL_JIT_EQUAL: setcc=0x94; break;
+		case ODL_JIT_OR:{
+			/* or rax, rcx; setne al; movzx eax, al */
+			unsigned char or[]={0x48, 0x09, 0xc8, 0x0f, 0x95, 0xc0, 0x0f, 0xb6, 0xc0};
+			emitJit(c, or, sizeof(or));
+		}break;
+		case ODL_JIT_AND:
+		case ODL_JIT_XOR:{
+			/* test rax, rax; setne al; test rcx, rcx; setne cl; and/xor al, cl; movzx eax, al */
+			unsigned char logic[]={0x48, 0x85, 0xc0, 0x0f, 0x95, 0xc0, 0x48, 0x85, 0xc9, 0x0f, 0x95, 0xc1, op==ODL_JIT_AND ? 0x20 : 0x30, 0xc8, 0x0f, 0xb6, 0xc0};
+			emitJit(c, logic, sizeof(logic));
+		}break;
+		default:
+		break;
+	}
+	if(setcc){
+		/* cmp rax, rcx; setcc al; movzx eax, al */
+		unsigned char compare[]={0x48, 0x39, 0xc8, 0x0f, setcc, 0xc0, 0x0f, 0xb6, 0xc0};
+		emitJit(c, compare, sizeof(compare));
+	}
+	unsigned char push[]={0x50};
+	emitJit(c, push, 1);
+}
+
+void initJitCompiler(ODLJitCompiler * c, ODLDictionary * dictionary){
+	memset(c, 0, sizeof(ODLJitCompiler));
+	c->dictionary=dictionary;
+	c->jit=malloc(sizeof(ODLJitCode));
+	c->jit->holes=0;
+	c->jit->depCount=0;
+}
+
+void addJitCursor(ODLJitCompiler * c, ODLList * body){
+	c->cursors[c->depth].it=body->bottom;
+	c->cursors[c->depth].end=body->top;
+	c->depth++;
+}
+
+ODLJitCode * finishJit(ODLJitCompiler * c);
+
+ODLJitCode * compileJit(ODLDictionary * dictionary, ODLDefStack * entry){
+	ODLJitCompiler c;
+	initJitCompiler(&c, dictionary);
+	addJitDep(&c, entry);
+	addJitCursor(&c, (entry->code->top-1)->value.list);
+	return finishJit(&c);
+}
+
+ODLJitCode * finishJit(ODLJitCompiler * c){
+	/* push rbp; mov rbp, rsp */
+	unsigned char prologue[]={0x55, 0x48, 0x89, 0xe5};
+	emitJit(c, prologue, sizeof(prologue));
+
+	compileJitExpression(c);
+
+	/* A body that is only a literal is not worth compiling, and one that is
+	   empty must not take anything from the stack. */
+	if(c->operators==0){
+		c->failed=1;
+	}
+
+	while(!c->failed && c->depth>0){
+		ODLJitCursor * cursor=c->cursors+c->depth-1;
+		if(cursor->it!=cursor->end){
+			c->failed=1;
+		}
+		c->depth--;
+	}
+
+	/* pop rax; mov [rsi], rax; mov eax, 1; pop rbp; ret */
+	unsigned char epilogue[]={0x58, 0x48, 0x89, 0x06, 0xb8, 0x01, 0x00, 0x00, 0x00, 0x5d, 0xc3};
+	emitJit(c, epilogue, sizeof(epilogue));
+	size_t deopt=c->length;
+	/* mov rsp, rbp; pop rbp; xor eax, eax; ret */
+	unsigned char fail[]={0x48, 0x89, 0xec, 0x5d, 0x31, 0xc0, 0xc3};
+	emitJit(c, fail, sizeof(fail));
+
+	if(c->failed){
+		free(c->code);
+		free(c->jit);
+		return NULL;
+	}
+
+	for(int i=0; i<c->deoptCount; i++){
+		int32_t rel=deopt-(c->deopts[i]+4);
+		memcpy(c->code+c->deopts[i], &rel, 4);
+	}
+
+	size_t page=sysconf(_SC_PAGESIZE);
+	c->jit->size=(c->length+page-1)/page*page;
+	void * mem=mmap(NULL, c->jit->size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if(mem==MAP_FAILED){
+		free(c->code);
+		free(c->jit);
+		return NULL;
+	}
+	memcpy(mem, c->code, c->length);
+	free(c->code);
+	if(mprotect(mem, c->jit->size, PROT_READ | PROT_EXEC)){
+		munmap(mem, c->jit->size);
+		free(c->jit);
+		return NULL;
+	}
+	c->jit->function=(ODLJitFunction)mem;
+	c->jit->refs=1;
+	return c->jit;
+}
+
+/* Drops any compiled code and waits twice as long before trying again, so
+   that names rebound on every call, like let variables, stop being
+   recompiled. */
+void releaseJit(ODLJitCode * jit){
+	if(--jit->refs==0){
+		munmap((void *)jit->function, jit->size);
+		free(jit);
+	}
+}
+
+void freeJit(ODLDefStack * entry){
+	if(entry->jit){
+		releaseJit(entry->jit);
+		entry->jit=NULL;
+	}
+	entry->calls=0;
+	if(entry->backoff<16){
+		entry->backoff++;
+	}
+}
+
+/* Compiles count consecutive stages of a map and filter pipeline, the first
+   of them innermost, as one function of the element. The outermost body is
+   read first, and running off its end continues into the next one in, as if
+   they had been written out one after the other. Pipelines over fewer than
+   jitThreshold elements are left to the interpreter. */
+ODLJitCode * compileJitStages(ODLDictionary * dictionary, ODLData * stage, int count, size_t elements){
+	if(!jitEnabled || dictionary->parent!=NULL || elements<jitThreshold || count>ODL_JIT_MAX_DEPTH){
+		return NULL;
+	}
+	ODLJitCompiler c;
+	initJitCompiler(&c, dictionary);
+	for(int i=0; i<count; i++){
+		ODLData * body=stage-2*i+1;
+		if(body->type!=ODL_LIST){
+			free(c.jit);
+			return NULL;
+		}
+		addJitCursor(&c, body->value.list);
+	}
+	ODLJitCode * jit=finishJit(&c);
+	if(jit!=NULL && jit->holes!=1){
+		releaseJit(jit);
+		return NULL;
+	}
+	return jit;
+}
+
+/* Runs code from compileJitStages on the element arg. Returns 0 if the
+   interpreter has to run the stages instead. */
+char callJitStage(ODLDictionary * dictionary, ODLJitCode * jit, ODLData * arg, ODLInt * result){
+	for(int i=0; i<jit->depCount; i++){
+		if(entryAtODL(dictionary, jit->deps[i].index)->version!=jit->deps[i].version){
+			return 0;
+		}
+	}
+	return jit->function(arg+1, result);
+}
+
+void releaseJitODL(void * jit){
+	releaseJit(jit);
+}
+
+/* Runs once the operands a compiled definition takes from the stack have
+   been evaluated. They lie under the definition the code was compiled from,
+   which the frame holds on to with the code itself, so if a guard fails the
+   definition is unrolled on top of them and the interpreter carries on as if
+   it had never been compiled. */
+void jitResumeODLB(ODLList * stack, ODLDictionary * dictionary){
+	ODLJitCode * jit=dictionary->control.state;
+	ODLData def=popODL(stack);
+
+	ODLData d;
+	d.type=ODL_INT;
+	if(jit->function(stack->top, &d.value.integer)){
+		for(int i=0; i<jit->holes; i++){
+			ODLData hole=popODL(stack);
+			freeODL(&hole);
+		}
+		freeODL(&def);
+		pushODL(stack, d);
+	}else{
+		pushODL(stack, def);
+		unrollODL(stack, dictionary);
+	}
+	releaseJit(jit);
+}
+
+/* Called instead of unrolling a list definition. Returns 1 if compiled code
+   has taken over the call, or 0 if the interpreter should run the
+   definition. */
+char runJitODL(ODLList * stack, ODLDictionary * dictionary, ODLDefStack * entry){
+	if(!jitEnabled || dictionary->parent!=NULL){
+		return 0;
+	}
+	ODLJitCode * jit=entry->jit;
+	if(jit==NULL){
+		if(++entry->calls<(jitThreshold<<entry->backoff)){
+			return 0;
+		}
+		jit=entry->jit=compileJit(dictionary, entry);
+		if(jit==NULL){
+			freeJit(entry);
+			return 0;
+		}
+	}
+
+	for(int i=0; i<jit->depCount; i++){
+		if(entryAtODL(dictionary, jit->deps[i].index)->version!=jit->deps[i].version){
+			freeJit(entry);
+			return 0;
+		}
+	}
+
+	if(jit->holes==0){
+		ODLData d;
+		d.type=ODL_INT;
+		if(!jit->function(stack->top, &d.value.integer)){
+			return 0;
+		}
+		pushODL(stack, d);
+		return 1;
+	}
+
+	jit->refs++;
+	ODLFrame * frame=pushFrameODL(dictionary, &jitResumeODLB, jit->holes);
+	frame->state=jit;
+	frame->release=&releaseJitODL;
+	pushODL(&dictionary->control.values, copyODL(*(entry->code->top-1)));
+	return 1;
+}
+
+/* Inference. When a list is defined its body is walked as prefix code,
+   keeping a set of possible types for each value, as far as it is made of
+   literals, quoted symbols and lists, the pure builtins in signatures and
+   definitions already known to take a fixed number of values and leave one.
+   Operands missing from the end of the body come from the stack and can be
+   anything. This gives the definition's stack effect and result types, and:
+
+   - A builtin applied to a literal, or to the result of another builtin,
+     that it can never accept is reported and the definition is undone.
+   - Up to the first token it can not follow, the body is copied with the
+     builtins it names already looked up, and with unchecked variants of
+     the builtins whose operands are known to be ints. Calls run the copy
+     while the entries it was built from are unchanged, like the JIT, so
+     the words are not looked up on every call.
+
+   Definitions that are rebound at run time, as let does, can hold anything
+   later, so only literals and builtin results are trusted for rejecting. */
+
+#define ODL_INFER_MAX_TOKENS 256
+#define ODL_INFER_MAX_DEPTH 64
+
+typedef unsigned int ODLTypes;
+
+#define ODL_TYPE(type) (1u<<(type))
+#define ODL_ANY_TYPE (~0u)
+#define ODL_NUMBER_TYPES (ODL_TYPE(ODL_INT) | ODL_TYPE(ODL_NUM) | ODL_TYPE(ODL_BIGINT))
+#define ODL_SEQUENCE_TYPES (ODL_TYPE(ODL_LIST) | ODL_TYPE(ODL_SEQ))
+
+/* The unchecked variants. Their operands are known to be ints, so they only
+   watch for overflow, handing that to the checked builtin. */
+
+void addIntODLB(ODLList * stack, ODLDictionary * dictionary){
+	ODLData * top=stack->top;
+	ODLInt result;
+	if(__builtin_add_overflow(top[-1].value.integer, top[-2].value.integer, &result)){
+		addODLB(stack, dictionary);
+		return;
+	}
+	top[-2].value.integer=result;
+	stack->top--;
+}
+
+void minusIntODLB(ODLList * stack, ODLDictionary * dictionary){
+	ODLData * top=stack->top;
+	ODLInt result;
+	if(__builtin_sub_overflow(top[-1].value.integer, top[-2].value.integer, &result)){
+		minusODLB(stack, dictionary);
+		return;
+	}
+	top[-2].value.integer=result;
+	stack->top--;
+}
+
+void multiplyIntODLB(ODLList * stack, ODLDictionary * dictionary){
+	ODLData * top=stack->top;
+	ODLInt result;
+	if(__builtin_mul_overflow(top[-1].value.integer, top[-2].value.integer, &result)){
+		multiplyODLB(stack, dictionary);
+		return;
+	}
+	top[-2].value.integer=result;
+	stack->top--;
+}
+
+void lessThanIntODLB(ODLList * stack, ODLDictionary * dictionary){
+	ODLData * top=--stack->top;
+	top[-1].value.integer=top[0].value.integer<top[-1].value.integer;
+}
+
+void lessThanEqualIntODLB(ODLList * stack, ODLDictionary * dictionary){
+	ODLData * top=--stack->top;
+	top[-1].value.integer=top[0].value.integer<=top[-1].value.integer;
+}
+
+void greaterThanIntODLB(ODLList * stack, ODLDictionary * dictionary){
+	ODLData * top=--stack->top;
+	top[-1].value.integer=top[0].value.integer>top[-1].value.integer;
+}
+
+void greaterThanEqualIntODLB(ODLList * stack, ODLDictionary * dictionary){
+	ODLData * top=--stack->top;
+	top[-1].value.integer=top[0].value.integer>=top[-1].value.integer;
+}
+
+void equalIntODLB(ODLList * stack, ODLDictionary * dictionary){
+	ODLData * top=--stack->top;
+	top[-1].value.integer=top[0].value.integer==top[-1].value.integer;
+}
+
+/* result 0 means the usual arithmetic rule: ints and bigints give an int or
+   a bigint, anything with a float gives a float. */
+typedef struct ODLSignature {
+	ODLBuiltin builtin;
+	ODLTypes operands[2];
+	ODLTypes result;
+	ODLBuiltinDef fast;
+} ODLSignature;
+
+ODLSignature signatures[]={
+	{&addODLB, {ODL_NUMBER_TYPES, ODL_NUMBER_TYPES}, 0, {&addIntODLB, 2}},
+	{&minusODLB, {ODL_NUMBER_TYPES, ODL_NUMBER_TYPES}, 0, {&minusIntODLB, 2}},
+	{&multiplyODLB, {ODL_NUMBER_TYPES, ODL_NUMBER_TYPES}, 0, {&multiplyIntODLB, 2}},
+	{&divideODLB, {ODL_NUMBER_TYPES, ODL_NUMBER_TYPES}, ODL_TYPE(ODL_NUM), {NULL, 0}},
+	{&lessThanODLB, {ODL_NUMBER_TYPES, ODL_NUMBER_TYPES}, ODL_TYPE(ODL_INT), {&lessThanIntODLB, 2}},
+	{&lessThanEqualODLB, {ODL_NUMBER_TYPES, ODL_NUMBER_TYPES}, ODL_TYPE(ODL_INT), {&lessThanEqualIntODLB, 2}},
+	{&greaterThanODLB, {ODL_NUMBER_TYPES, ODL_NUMBER_TYPES}, ODL_TYPE(ODL_INT), {&greaterThanIntODLB, 2}},
+	{&greaterThanEqualODLB, {ODL_NUMBER_TYPES, ODL_NUMBER_TYPES}, ODL_TYPE(ODL_INT), {&greaterThanEqualIntODLB, 2}},
+	{&equalODLB, {ODL_ANY_TYPE, ODL_ANY_TYPE}, ODL_TYPE(ODL_INT), {&equalIntODLB, 2}},
+	{&andODLB, {ODL_TYPE(ODL_INT), ODL_TYPE(ODL_INT)}, ODL_TYPE(ODL_INT), {NULL, 0}},
+	{&orODLB, {ODL_TYPE(ODL_INT), ODL_TYPE(ODL_INT)}, ODL_TYPE(ODL_INT), {NULL, 0}},
+	{&xorODLB, {ODL_TYPE(ODL_INT), ODL_TYPE(ODL_INT)}, ODL_TYPE(ODL_INT), {NULL, 0}},
+	{&lengthODLB, {ODL_SEQUENCE_TYPES | ODL_TYPE(ODL_STRING) | ODL_TYPE(ODL_OBJECT), 0}, ODL_TYPE(ODL_INT), {NULL, 0}},
+	{&emptyODLB, {ODL_SEQUENCE_TYPES | ODL_TYPE(ODL_STRING) | ODL_TYPE(ODL_OBJECT), 0}, ODL_TYPE(ODL_INT), {NULL, 0}},
+	{&getODLB, {ODL_SEQUENCE_TYPES, ODL_TYPE(ODL_INT)}, ODL_ANY_TYPE, {NULL, 0}},
+	{&lookupODLB, {ODL_TYPE(ODL_OBJECT), ODL_ANY_TYPE}, ODL_ANY_TYPE, {NULL, 0}},
+	{&hasODLB, {ODL_TYPE(ODL_OBJECT), ODL_ANY_TYPE}, ODL_TYPE(ODL_INT), {NULL, 0}},
+	{&keysODLB, {ODL_TYPE(ODL_OBJECT), 0}, ODL_TYPE(ODL_LIST), {NULL, 0}},
+};
+
+ODLSignature * findSignature(ODLBuiltin builtin){
+	for(int i=0; i<sizeof(signatures)/sizeof(ODLSignature); i++){
+		if(signatures[i].builtin==builtin){
+			return signatures+i;
+		}
+	}
+	return NULL;
+}
+
+/* The builtins in signatures, and their unchecked variants, take their
+   arity in values and leave one. */
+char builtinEffectODL(ODLBuiltinDef * builtin, int * in, int * out){
+	for(int i=0; i<sizeof(signatures)/sizeof(ODLSignature); i++){
+		if(signatures[i].builtin==builtin->call || signatures[i].fast.call==builtin->call){
+			*in=builtin->arity;
+			*out=1;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/* What a call of a definition has been inferred to do. body is the copy to
+   run instead, NULL if nothing in it could be resolved ahead of time. */
+struct ODLTyped {
+	size_t version;
+	int in;
+	int out;
+	char complete;
+	ODLTypes result;
+	ODLList * body;
+	int depCount;
+	ODLJitDep deps[ODL_JIT_MAX_DEPS];
+};
+
+typedef struct ODLPending {
+	ODLSignature * signature;
+	ODLWord name;
+	int arity;
+	int count;
+	size_t index;
+	ODLTypes result;
+	ODLTypes known[2];
+	ODLTypes proven[2];
+} ODLPending;
+
+typedef struct ODLInference {
+	ODLDictionary * dictionary;
+	ODLData * tokens;
+	ODLWord name;
+	char specialise;
+	ODLPending pending[ODL_INFER_MAX_DEPTH];
+	int depth;
+	ODLTyped * typed;
+	ODLData replaced[ODL_INFER_MAX_TOKENS];
+	char replace[ODL_INFER_MAX_TOKENS];
+	char rejected;
+} ODLInference;
+
+char * typeNameODL(ODLTypes types){
+	char * names[]={"Error", "Word", "Num", "List", "Object", "String", "Int", "Builtin", "Symbol", "BigInt", "Sequence"};
+	for(int i=0; i<sizeof(names)/sizeof(char *); i++){
+		if(types & ODL_TYPE(i)){
+			return names[i];
+		}
+	}
+	return "value";
+}
+
+/* Inside an overlay nothing is specialised, as the JIT does nothing there
+   either, so no dependencies are kept. */
+char addInferDep(ODLInference * inference, ODLDefStack * entry){
+	if(!inference->specialise){
+		return 1;
+	}
+	ODLTyped * typed=inference->typed;
+	size_t index=entry->position;
+	for(int i=0; i<typed->depCount; i++){
+		if(typed->deps[i].index==index){
+			return 1;
+		}
+	}
+	if(typed->depCount>=ODL_JIT_MAX_DEPS){
+		return 0;
+	}
+	typed->deps[typed->depCount].index=index;
+	typed->deps[typed->depCount].version=entry->version;
+	typed->depCount++;
+	return 1;
+}
+
+void replaceInferToken(ODLInference * inference, size_t index, ODLBuiltinDef * builtin){
+	ODLData * token=inference->tokens+index;
+	if(token->type==ODL_BUILTIN && token->value.builtin==builtin){
+		return;
+	}
+	inference->replace[index]=1;
+	inference->replaced[index].type=ODL_BUILTIN;
+	inference->replaced[index].value.builtin=builtin;
+}
+
+/* Hands a value to the innermost builtin waiting for operands, applying it
+   once it has them all, or counts it as left by the body. */
+void feedInferValue(ODLInference * inference, ODLTypes known, ODLTypes proven){
+	while(1){
+		if(inference->depth==0){
+			inference->typed->out++;
+			inference->typed->result=known;
+			return;
+		}
+		ODLPending * pending=inference->pending+inference->depth-1;
+		if(pending->count<2){
+			pending->known[pending->count]=known;
+			pending->proven[pending->count]=proven;
+		}
+		if(++pending->count<pending->arity){
+			return;
+		}
+		inference->depth--;
+
+		ODLSignature * signature=pending->signature;
+		if(signature==NULL){
+			known=pending->result;
+			proven=ODL_ANY_TYPE;
+			continue;
+		}
+		for(int i=0; i<pending->arity && i<2; i++){
+			if((pending->proven[i] & signature->operands[i])==0){
+				fprintf(outODL, "In %s, %s can not take %s as argument %d", inference->name, pending->name, typeNameODL(pending->proven[i]), i+1);
+				inference->rejected=1;
+				return;
+			}
+		}
+		char ints=pending->arity==2 && pending->known[0]==ODL_TYPE(ODL_INT) && pending->known[1]==ODL_TYPE(ODL_INT);
+		if(ints && signature->fast.call!=NULL){
+			replaceInferToken(inference, pending->index, &signature->fast);
+		}
+		if(signature->result!=0){
+			known=signature->result;
+			proven=signature->result;
+		}else{
+			ODLTypes integral=ODL_TYPE(ODL_INT) | ODL_TYPE(ODL_BIGINT);
+			known=(pending->known[0] | pending->known[1]) & ~integral ? ODL_NUMBER_TYPES : integral;
+			proven=(pending->proven[0] | pending->proven[1]) & ~integral ? ODL_NUMBER_TYPES : integral;
+		}
+	}
+}
+
+/* The index just past the ) closing the bracket opened at start, or 0 if
+   the list splices in evaluated values or is not closed. */
+size_t matchBracketODL(ODLData * tokens, size_t start, size_t length){
+	int depth=1;
+	for(size_t i=start+1; i<length; i++){
+		if(tokens[i].type!=ODL_WORD){
+			continue;
+		}
+		char * word=tokens[i].value.word;
+		if(strcmp(word, "(")==0 || strcmp(word, "`(")==0){
+			depth++;
+		}else if(strcmp(word, ")")==0){
+			if(--depth==0){
+				return i+1;
+			}
+		}else if(depth==1 && strcmp(word, "`")==0){
+			return 0;
+		}
+	}
+	return 0;
+}
+
+/* The specialised body to run for a call of entry, if it is still valid. */
+ODLList * typedBodyODL(ODLDictionary * dictionary, ODLDefStack * entry){
+	ODLTyped * typed=entry->typed;
+	if(typed->body==NULL || typed->version!=entry->version){
+		return NULL;
+	}
+	for(int i=0; i<typed->depCount; i++){
+		if(entryAtODL(dictionary, typed->deps[i].index)->version!=typed->deps[i].version){
+			return NULL;
+		}
+	}
+	return typed->body;
+}
+
+void freeTypedODL(ODLTyped * typed){
+	if(typed->body!=NULL){
+		freeListODL(typed->body);
+	}
+	free(typed);
+}
+
+/* Walks the body of the list just defined as name. Returns 0 if it can be
+   shown to be wrong, after printing why. */
+char inferODL(ODLDictionary * dictionary, ODLDefStack * entry){
+	ODLList * list=(entry->code->top-1)->value.list;
+	ODLData * tokens=list->bottom;
+	size_t length=list->top-list->bottom;
+	if(length>ODL_INFER_MAX_TOKENS){
+		return 1;
+	}
+
+	ODLInference * inference=malloc(sizeof(ODLInference));
+	inference->dictionary=dictionary;
+	inference->tokens=tokens;
+	inference->name=entry->name;
+	inference->specialise=dictionary->parent==NULL;
+	inference->depth=0;
+	inference->rejected=0;
+	memset(inference->replace, 0, length);
+	ODLTyped * typed=malloc(sizeof(ODLTyped));
+	inference->typed=typed;
+	typed->version=entry->version;
+	typed->in=0;
+	typed->out=0;
+	typed->result=ODL_ANY_TYPE;
+	typed->body=NULL;
+	typed->depCount=0;
+	addInferDep(inference, entry);
+
+	size_t i=0;
+	while(i<length && !inference->rejected){
+		ODLData * token=tokens+i;
+		ODLBuiltinDef * builtin=NULL;
+		ODLDefStack * word=NULL;
+		if(token->type==ODL_WORD){
+			word=findEntryInDictionary(dictionary, token->value.word);
+			if(word==NULL || word->code->top==word->code->bottom || !addInferDep(inference, word)){
+				break;
+			}
+			ODLData * bound=word->code->top-1;
+			if(bound->type==ODL_LIST){
+				ODLTyped * called=word->typed;
+				if(word==entry || called==NULL || !called->complete || called->out!=1 || called->version!=word->version
+					|| inference->depth>=ODL_INFER_MAX_DEPTH){
+					break;
+				}
+				i++;
+				if(called->in==0){
+					feedInferValue(inference, called->result, ODL_ANY_TYPE);
+					continue;
+				}
+				ODLPending * pending=inference->pending+inference->depth++;
+				pending->signature=NULL;
+				pending->arity=called->in;
+				pending->count=0;
+				pending->result=called->result;
+				continue;
+			}
+			if(bound->type!=ODL_BUILTIN){
+				i++;
+				feedInferValue(inference, ODL_TYPE(bound->type), ODL_ANY_TYPE);
+				continue;
+			}
+			builtin=bound->value.builtin;
+		}else if(token->type==ODL_BUILTIN){
+			builtin=token->value.builtin;
+		}else{
+			i++;
+			feedInferValue(inference, ODL_TYPE(token->type), ODL_TYPE(token->type));
+			continue;
+		}
+
+		if(builtin->call==&openBracketODLB){
+			size_t end=matchBracketODL(tokens, i, length);
+			if(end==0){
+				break;
+			}
+			replaceInferToken(inference, i, builtin);
+			i=end;
+			feedInferValue(inference, ODL_TYPE(ODL_LIST), ODL_TYPE(ODL_LIST));
+			continue;
+		}
+		if(builtin->call==&asSymbolODLB){
+			if(i+1>=length || tokens[i+1].type==ODL_BUILTIN){
+				break;
+			}
+			ODLTypes quoted=tokens[i+1].type==ODL_WORD ? ODL_TYPE(ODL_SYMBOL) : ODL_TYPE(tokens[i+1].type);
+			replaceInferToken(inference, i, builtin);
+			i+=2;
+			feedInferValue(inference, quoted, quoted);
+			continue;
+		}
+		ODLSignature * signature=findSignature(builtin->call);
+		if(signature==NULL || inference->depth>=ODL_INFER_MAX_DEPTH){
+			break;
+		}
+		replaceInferToken(inference, i, builtin);
+		ODLPending * pending=inference->pending+inference->depth++;
+		pending->signature=signature;
+		pending->name=token->type==ODL_WORD ? token->value.word : "builtin";
+		pending->arity=builtin->arity;
+		pending->count=0;
+		pending->index=i;
+		i++;
+	}
+
+	typed->complete=i==length && !inference->rejected;
+	while(typed->complete && inference->depth>0 && !inference->rejected){
+		typed->in++;
+		feedInferValue(inference, ODL_ANY_TYPE, ODL_ANY_TYPE);
+	}
+	if(inference->rejected){
+		free(inference);
+		free(typed);
+		return 0;
+	}
+
+	for(size_t j=0; j<i && inference->specialise; j++){
+		if(!inference->replace[j]){
+			continue;
+		}
+		if(typed->body==NULL){
+			typed->body=allocList(length);
+			for(size_t k=0; k<length; k++){
+				pushODL(typed->body, copyODL(tokens[k]));
+			}
+		}
+		typed->body->bottom[j]=inference->replaced[j];
+	}
+	free(inference);
+
+	if(entry->typed!=NULL){
+		freeTypedODL(entry->typed);
+	}
+	entry->typed=typed;
+	return 1;
+}
+
+/* Sets in and out to the number of values a call of entry takes and leaves.
+   Returns 0 if that could not be worked out. */
+char stackEffectODL(ODLDefStack * entry, int * in, int * out){
+	ODLData * def=entry->code->top-1;
+	if(def->type==ODL_BUILTIN){
+		return builtinEffectODL(def->value.builtin, in, out);
+	}
+	if(def->type!=ODL_LIST){
+		*in=0;
+		*out=1;
+		return 1;
+	}
+	if(entry->typed!=NULL && entry->typed->complete && entry->typed->version==entry->version){
+		*in=entry->typed->in;
+		*out=entry->typed->out;
+		return 1;
+	}
+	return 0;
+}
+
+/* effect $ name leaves ( in out ), the number of values a call of name takes
+   and leaves, or ( ) if that could not be worked out. */
+void effectODLB(ODLList * stack, ODLDictionary * dictionary){
+	ODLData named=popODL(stack);
+	if(named.type!=ODL_SYMBOL){
+		fprintf(outODL, "effect's argument is something other than a symbol\n");
+			freeODL(&named);
+		abortODL();
+	}
+	ODLDefStack * entry=findInDictionary(dictionary, named.value.word);
+
+	ODLData d;
+	d.type=ODL_LIST;
+	d.value.list=allocList(2);
+	ODLData count;
+	count.type=ODL_INT;
+	int in, out;
+	if(stackEffectODL(entry, &in, &out)){
+		count.value.integer=in;
+		pushODL(d.value.list, count);
+		count.value.integer=out;
+		pushODL(d.value.list, count);
+	}
+	pushODL(stack, d);
+}
+
+/* Fibers. spawn wraps a body in a fiber with its own stack and control stack
+   and an overlay on the top level dictionary, so its definitions stay private
+   to it. Nothing runs until something joins: join then gives every live fiber
+   a slice of schedulerODL.steps steps in turn, round robin, until the one it
+   wants has finished, and returns the values that fiber produced as a list.
+   An error in a fiber ends that fiber only. */
+
+typedef struct ODLFiber{
+	ODLInt id;
+	ODLDictionary * dictionary;
+	ODLList * stack;
+	ODLList * results;
+	char running;
+	char done;
+} ODLFiber;
+
+typedef struct ODLScheduler{
+	size_t alloc;
+	size_t count;
+	ODLFiber ** fibers;
+	ODLInt next;
+	size_t steps;
+} ODLScheduler;
+
+__thread ODLScheduler schedulerODL={0, 0, NULL, 1, 1000};
+
+void recoverODLState(ODLDictionary * dictionary, size_t * depths, size_t count);
+void freeDictionaryODL(ODLDictionary * dictionary);
+
+ODLDictionary * overlayDictionary(ODLDictionary * parent){
+	ODLDictionary * dictionary=malloc(sizeof(ODLDictionary));
+	initDefsODL(dictionary, 16);
+
+	dictionary->control.count=0;
+	dictionary->control.alloc=16;
+	dictionary->control.frames=malloc(dictionary->control.alloc*sizeof(ODLFrame));
+	initList(&dictionary->control.values, 16);
+
+	dictionary->parent=parent;
+	dictionary->map=parent->map;
+	dictionary->modules=NULL;
+	dictionary->builtins=NULL;
+	return dictionary;
+}
+
+void freeFiber(ODLFiber * fiber){
+	freeDictionaryODL(fiber->dictionary);
+	freeListODL(fiber->stack);
+	freeListODL(fiber->results);
+	free(fiber);
+}
+
+size_t findFiber(ODLInt id){
+	for(size_t i=0; i<schedulerODL.count; i++){
+		if(schedulerODL.fibers[i]->id==id){
+			return i;
+		}
+	}
+	return SIZE_MAX;
+}
+
+/* Runs one slice of a fiber. A value it leaves on top of its stack is moved
+   to its results, and it is done once the stack is empty. */
+void sliceFiber(ODLFiber * fiber){
+	jmp_buf * outer=recoverODL;
+	ODLHold * outerFloor=holdFloorODL;
+	jmp_buf recover;
+	fiber->running=1;
+	if(setjmp(recover)==0){
+		recoverODL=&recover;
+		holdFloorODL=holdsODL;
+		if(runODL(fiber->stack, fiber->dictionary, 0, schedulerODL.steps)){
+			if(fiber->stack->top>fiber->stack->bottom){
+				pushODL(fiber->results, popODL(fiber->stack));
+			}
+			fiber->done=fiber->stack->top==fiber->stack->bottom;
+		}
+	}else{
+		fprintf(outODL, "\n");
+		recoverODLState(fiber->dictionary, NULL, 0);
+		fiber->done=1;
+	}
+	recoverODL=outer;
+	holdFloorODL=outerFloor;
+	fiber->running=0;
+}
+
+void spawnODLB(ODLList * stack, ODLDictionary * dictionary){
+	ODLData body=popODL(stack);
+
+	while(dictionary->parent!=NULL){
+		dictionary=dictionary->parent;
+	}
+
+	ODLFiber * fiber=malloc(sizeof(ODLFiber));
+	fiber->id=schedulerODL.next++;
+	fiber->dictionary=overlayDictionary(dictionary);
+	fiber->stack=allocList(64);
+	fiber->results=allocList(8);
+	fiber->running=0;
+	fiber->done=0;
+	pushODL(fiber->stack, body);
+	unrollODL(fiber->stack, fiber->dictionary);
+
+	if(schedulerODL.count>=schedulerODL.alloc){
+		schedulerODL.alloc=schedulerODL.alloc ? schedulerODL.alloc*2 : 16;
+		schedulerODL.fibers=realloc(schedulerODL.fibers, schedulerODL.alloc*sizeof(ODLFiber *));
+	}
+	schedulerODL.fibers[schedulerODL.count++]=fiber;
+
+	ODLData d;
+	d.type=ODL_INT;
+	d.value.integer=fiber->id;
+	pushODL(stack, d);
+}
+
+void joinODLB(ODLList * stack, ODLDictionary * dictionary){
+	ODLData top=popODL(stack);
+	if(top.type!=ODL_INT){
+		fprintf(outODL, "Tried join with non-fiber");
+		freeODL(&top);
+		abortODL();
+	}
+	ODLInt id=top.value.integer;
+
+	size_t index=findFiber(id);
+	if(index==SIZE_MAX){
+		fprintf(outODL, "Unknown fiber %lld\n", (long long)id);
+		abortODL();
+	}
+	if(schedulerODL.fibers[index]->running){
+		fprintf(outODL, "Fiber %lld is already running\n", (long long)id);
+		abortODL();
+	}
+
+	/* Fibers run by a slice may join and free others, so the target is
+	   looked up again after each one. */
+	while(!schedulerODL.fibers[index]->done){
+		for(size_t i=0; i<schedulerODL.count; i++){
+			ODLFiber * fiber=schedulerODL.fibers[i];
+			if(!fiber->running && !fiber->done){
+				sliceFiber(fiber);
+			}
+		}
+		index=findFiber(id);
+		if(index==SIZE_MAX){
+			fprintf(outODL, "Fiber %lld was joined elsewhere\n", (long long)id);
+			abortODL();
+		}
+	}
+
+	ODLFiber * fiber=schedulerODL.fibers[index];
+	schedulerODL.count--;
+	memmove(schedulerODL.fibers+index, schedulerODL.fibers+index+1, (schedulerODL.count-index)*sizeof(ODLFiber *));
+
+	ODLData d;
+	d.type=ODL_LIST;
+	d.value.list=fiber->results;
+	retainODL(&fiber->results->refs);
+	freeFiber(fiber);
+	pushODL(stack, d);
+}
+
+void freeFibersODL(){
+	for(size_t i=0; i<schedulerODL.count; i++){
+		freeFiber(schedulerODL.fibers[i]);
+	}
+	free(schedulerODL.fibers);
+	schedulerODL.count=0;
+	schedulerODL.alloc=0;
+	schedulerODL.fibers=NULL;
+}
+
+/* Serialization. A serialized value is
+
+     "ODLV", a version byte,
+     the number of distinct words, then each word as its length and bytes,
+     the value.
+
+   A value is a tag byte followed by
+     ODL_INT: the zigzag varint of the int
+     ODL_NUM: the 8 bytes of the double
+     ODL_WORD, ODL_SYMBOL: the varint index of the word in the table
+     ODL_STRING: the varint length and the bytes
+     ODL_BIGINT: a sign byte, the varint limb count and the limbs, 4 bytes
+       each, least significant first
+     ODL_LIST: the varint count and the elements, bottom first
+     ODL_OBJECT: the varint count and each key followed by its value
+
+   Lengths and counts are varints too. Nothing in it is a pointer or an
+   offset, so it can be decoded straight out of a mapped file. Sequences
+   and builtins can not be serialized. Doubles and limbs are little endian
+   whatever the host is, so a saved value loads on any machine. */
+
+#define ODL_SERIAL_VERSION 1
+#define ODL_SERIAL_MAX_DEPTH 4096
+
+typedef struct ODLWordTable {
+	size_t alloc;
+	size_t count;
+	ODLWord * slots;
+	size_t * indices;
+	ODLWord * words;
+} ODLWordTable;
+
+void appendVarintODL(ODLBuffer * buffer, uint64_t v){
+	unsigned char bytes[10];
+	int count=0;
+	do{
+		bytes[count++]=(v & 0x7f) | (v>=0x80 ? 0x80 : 0);
+		v>>=7;
+	}while(v);
+	appendODL(buffer, (char *)bytes, count);
+}
+
+/* The shifts compile to a plain load or store where they can. */
+uint64_t littleEndianODL(unsigned char * p, size_t width){
+	uint64_t v=0;
+	for(size_t i=0; i<width; i++){
+		v|=(uint64_t)p[i]<<(8*i);
+	}
+	return v;
+}
+
+void appendLittleEndianODL(ODLBuffer * buffer, uint64_t v, size_t width){
+	unsigned char bytes[8];
+	for(size_t i=0; i<width; i++){
+		bytes[i]=v>>(8*i);
+	}
+	appendODL(buffer, (char *)bytes, width);
+}
+
+/* Words are interned, so they are told apart by address. */
+size_t wordIndexODL(ODLWordTable * table, ODLWord word){
+	if(table->count*2>=table->alloc){
+		ODLWord * slots=table->slots;
+		size_t * indices=table->indices;
+		size_t alloc=table->alloc;
+		table->alloc=alloc ? alloc*2 : 64;
+		table->slots=calloc(table->alloc, sizeof(ODLWord));
+		table->indices=malloc(table->alloc*sizeof(size_t));
+		table->words=realloc(table->words, table->alloc*sizeof(ODLWord));
+		for(size_t i=0; i<alloc; i++){
+			if(slots[i]==NULL){
+				continue;
+			}
+			size_t slot=((uintptr_t)slots[i]>>3)&(table->alloc-1);
+			while(table->slots[slot]!=NULL){
+				slot=(slot+1)&(table->alloc-1);
+			}
+			table->slots[slot]=slots[i];
+			table->indices[slot]=indices[i];
+		}
+		free(slots);
+		free(indices);
+	}
+	size_t slot=((uintptr_t)word>>3)&(table->alloc-1);
+	while(table->slots[slot]!=NULL){
+		if(table->slots[slot]==word){
+			return table->indices[slot];
+		}
+		slot=(slot+1)&(table->alloc-1);
+	}
+	table->slots[slot]=word;
+	table->indices[slot]=table->count;
+	table->words[table->count]=word;
+	return table->count++;
+}
+
+char collectWordsODL(ODLWordTable * table, ODLData * d, int depth);
+
+char collectNodeWordsODL(ODLWordTable * table, ODLHamtNode * node, int depth){
+	for(uint32_t i=0; i<2*node->pairCount; i++){
+		if(!collectWordsODL(table, node->pairs+i, depth+1)){
+			return 0;
+		}
+	}
+	for(uint32_t i=0; i<node->nodeCount; i++){
+		if(!collectNodeWordsODL(table, node->nodes[i], depth)){
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/* Returns 0 on something that can not be serialized. */
+char collectWordsODL(ODLWordTable * table, ODLData * d, int depth){
+	if(depth>ODL_SERIAL_MAX_DEPTH){
+		return 0;
+	}
+	if(d->type==ODL_WORD || d->type==ODL_SYMBOL){
+		wordIndexODL(table, d->value.word);
+	}else if(d->type==ODL_LIST){
+		for(ODLData * it=d->value.list->bottom; it<d->value.list->top; it++){
+			if(!collectWordsODL(table, it, depth+1)){
+				return 0;
+			}
+		}
+	}else if(d->type==ODL_OBJECT){
+		return collectNodeWordsODL(table, d->value.object->root, depth);
+	}else if(d->type==ODL_SEQ || d->type==ODL_BUILTIN){
+		return 0;
+	}
+	return 1;
+}
+
+void encodeODL(ODLBuffer * buffer, ODLWordTable * table, ODLData * d);
+
+void encodeNodeODL(ODLBuffer * buffer, ODLWordTable * table, ODLHamtNode * node){
+	for(uint32_t i=0; i<2*node->pairCount; i++){
+		encodeODL(buffer, table, node->pairs+i);
+	}
+	for(uint32_t i=0; i<node->nodeCount; i++){
+		encodeNodeODL(buffer, table, node->nodes[i]);
+	}
+}
+
+void encodeODL(ODLBuffer * buffer, ODLWordTable * table, ODLData * d){
+	char tag=d->type;
+	appendODL(buffer, &tag, 1);
+	switch(d->type){
+		case ODL_INT:
+			appendVarintODL(buffer, ((uint64_t)d->value.integer<<1)^(uint64_t)(d->value.integer>>63));
+		break;
+		case ODL_NUM:{
+			uint64_t bits;
+			memcpy(&bits, &d->value.num, sizeof(bits));
+			appendLittleEndianODL(buffer, bits, sizeof(bits));
+		}
+		break;
+		case ODL_WORD:
+		case ODL_SYMBOL:
+			appendVarintODL(buffer, wordIndexODL(table, d->value.word));
+		break;
+		case ODL_STRING:
+			appendVarintODL(buffer, d->value.string->length);
+			appendODL(buffer, d->value.string->text, d->value.string->length);
+		break;
+		case ODL_BIGINT:
+			appendODL(buffer, &d->value.bigint->negative, 1);
+			appendVarintODL(buffer, d->value.bigint->count);
+			for(size_t i=0; i<d->value.bigint->count; i++){
+				appendLittleEndianODL(buffer, d->value.bigint->limbs[i], sizeof(uint32_t));
+			}
+		break;
+		case ODL_LIST:
+			appendVarintODL(buffer, d->value.list->top-d->value.list->bottom);
+			for(ODLData * it=d->value.list->bottom; it<d->value.list->top; it++){
+				encodeODL(buffer, table, it);
+			}
+		break;
+		case ODL_OBJECT:
+			appendVarintODL(buffer, d->value.object->size);
+			encodeNodeODL(buffer, table, d->value.object->root);
+		break;
+		default:
+		break;
+	}
+}
+
+/* Appends the serialization of d to buffer. Returns 0, appending nothing,
+   if d holds a sequence or a builtin. */
+char serializeODL(ODLBuffer * buffer, ODLData * d){
+	ODLWordTable table={0, 0, NULL, NULL, NULL};
+	char ok=collectWordsODL(&table, d, 0);
+	if(ok){
+		appendODL(buffer, "ODLV", 4);
+		char version=ODL_SERIAL_VERSION;
+		appendODL(buffer, &version, 1);
+		appendVarintODL(buffer, table.count);
+		for(size_t i=0; i<table.count; i++){
+			size_t length=strlen(table.words[i]);
+			appendVarintODL(buffer, length);
+			appendODL(buffer, table.words[i], length);
+		}
+		encodeODL(buffer, &table, d);
+	}
+	free(table.slots);
+	free(table.indices);
+	free(table.words);
+	return ok;
+}
+
+typedef struct ODLDecoder {
+	unsigned char * it;
+	unsigned char * end;
+	ODLWord * words;
+	size_t wordCount;
+} ODLDecoder;
+
+char readVarintODL(ODLDecoder * decoder, uint64_t * out){
+	uint64_t v=0;
+	for(int shift=0; shift<64; shift+=7){
+		if(decoder->it==decoder->end){
+			return 0;
+		}
+		unsigned char byte=*decoder->it++;
+		v|=(uint64_t)(byte & 0x7f)<<shift;
+		if(!(byte & 0x80)){
+			*out=v;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+char decodeODL(ODLDecoder * decoder, ODLData * d, int depth){
+	uint64_t v;
+	if(decoder->it==decoder->end || depth>ODL_SERIAL_MAX_DEPTH){
+		return 0;
+	}
+	d->type=*decoder->it++;
+	switch(d->type){
+		case ODL_INT:
+			if(!readVarintODL(decoder, &v)){
+				return 0;
+			}
+			d->value.integer=(ODLInt)((v>>1)^(0-(v & 1)));
+			return 1;
+		case ODL_NUM:
+			if(decoder->end-decoder->it<sizeof(ODLNum)){
+				return 0;
+			}
+			v=littleEndianODL(decoder->it, sizeof(v));
+			memcpy(&d->value.num, &v, sizeof(v));
+			decoder->it+=sizeof(ODLNum);
+			return 1;
+		case ODL_WORD:
+		case ODL_SYMBOL:
+			if(!readVarintODL(decoder, &v) || v>=decoder->wordCount){
+				return 0;
+			}
+			d->value.word=decoder->words[v];
+			return 1;
+		case ODL_STRING:
+			if(!readVarintODL(decoder, &v) || v>decoder->end-decoder->it){
+				return 0;
+			}
+			d->value.string=allocString(v);
+			memcpy(d->value.string->data, decoder->it, v);
+			decoder->it+=v;
+			return 1;
+		case ODL_BIGINT:{
+			if(decoder->it==decoder->end){
+				return 0;
+			}
+			char negative=*decoder->it++;
+			if(!readVarintODL(decoder, &v) || v>(decoder->end-decoder->it)/sizeof(uint32_t)){
+				return 0;
+			}
+			ODLBigInt * big=allocBigInt(v);
+			big->negative=negative!=0;
+			for(uint64_t i=0; i<v; i++){
+				big->limbs[i]=littleEndianODL(decoder->it, sizeof(uint32_t));
+				decoder->it+=sizeof(uint32_t);
+			}
+			trimBigInt(big);
+			*d=bigIntResult(big);
+			return 1;
+		}
+		case ODL_LIST:{
+			/* Every element takes at least two bytes, which bounds the count
+			   before anything is allocated for it. */
+			if(!readVarintODL(decoder, &v) || v>(decoder->end-decoder->it)/2){
+				return 0;
+			}
+			ODLList * list=allocList(v);
+			d->value.list=list;
+			for(uint64_t i=0; i<v; i++){
+				ODLData element;
+				if(!decodeODL(decoder, &element, depth+1)){
+					freeListODL(list);
+					return 0;
+				}
+				pushODL(list, element);
+			}
+			return 1;
+		}
+		case ODL_OBJECT:{
+			/* A key and a value take at least two bytes each. */
+			if(!readVarintODL(decoder, &v) || v>(decoder->end-decoder->it)/4){
+				return 0;
+			}
+			d->value.object=allocObjectODL(allocNodeODL(0, 0), 0);
+			for(uint64_t i=0; i<v; i++){
+				ODLData key, value;
+				if(!decodeODL(decoder, &key, depth+1)){
+					freeODL(d);
+					return 0;
+				}
+				if(!isMapKeyODL(&key) || !decodeODL(decoder, &value, depth+1)){
+					freeODL(&key);
+					freeODL(d);
+					return 0;
+				}
+				insertIntoObjectODL(d->value.object, key, value);
+			}
+			return 1;
+		}
+		default:
+			return 0;
+	}
+}
+
+/* Decodes the serialization in data, interning its words in map. Returns 0
+   if it is not one. */
+char deserializeODL(char * data, size_t length, ODLWordMap * map, ODLData * out){
+	ODLDecoder decoder;
+	decoder.it=(unsigned char *)data;
+	decoder.end=decoder.it+length;
+	decoder.words=NULL;
+	decoder.wordCount=0;
+	if(length<5 || memcmp(data, "ODLV", 4)!=0 || data[4]!=ODL_SERIAL_VERSION){
+		return 0;
+	}
+	decoder.it+=5;
+
+	uint64_t count;
+	if(!readVarintODL(&decoder, &count) || count>decoder.end-decoder.it){
+		return 0;
+	}
+	decoder.words=malloc((count+1)*sizeof(ODLWord));
+	char ok=1;
+	for(uint64_t i=0; i<count && ok; i++){
+		uint64_t wordLength;
+		ok=readVarintODL(&decoder, &wordLength) && wordLength<=decoder.end-decoder.it;
+		if(ok){
+			char word[wordLength+1];
+			memcpy(word, decoder.it, wordLength);
+			word[wordLength]=0;
+			decoder.it+=wordLength;
+			decoder.words[i]=findInWordMap(word, map);
+			decoder.wordCount++;
+		}
+	}
+	ok=ok && decodeODL(&decoder, out, 0);
+	if(ok && decoder.it!=decoder.end){
+		freeODL(out);
+		ok=0;
+	}
+	free(decoder.words);
+	return ok;
+}
+
+/* Writes to a temporary file beside path and renames it over path, so no
+   reader ever sees half of it. */
+char writeFileODL(char * path, char * data, size_t length){
+	char temporary[strlen(path)+48];
+	sprintf(temporary, "%s.%d.%lx", path, (int)getpid(), (unsigned long)pthread_self());
+	FILE * file=fopen(temporary, "wb");
+	if(file==NULL){
+		return 0;
+	}
+	size_t written=fwrite(data, 1, length, file);
+	if(fclose(file)!=0 || written!=length || rename(temporary, path)!=0){
+		unlink(temporary);
+		return 0;
+	}
+	return 1;
+}
+
+/* Maps path read only. Returns NULL, with *length 0, for an empty file. */
+char * mapFileODL(char * path, size_t * length, char * failed){
+	*failed=0;
+	*length=0;
+	int fd=open(path, O_RDONLY);
+	struct stat info;
+	if(fd<0 || fstat(fd, &info)<0){
+		if(fd>=0){
+			close(fd);
+		}
+		*failed=1;
+		return NULL;
+	}
+	*length=info.st_size;
+	char * data=NULL;
+	if(*length>0){
+		data=mmap(NULL, *length, PROT_READ, MAP_PRIVATE, fd, 0);
+		if(data==MAP_FAILED){
+			data=NULL;
+			*failed=1;
+		}
+	}
+	close(fd);
+	return data;
+}
+
+char * pathFromString(ODLData * d, char * name){
+	if(d->type!=ODL_STRING){
+		fprintf(outODL, "Tried %s with non-string", name);
+		freeODL(d);
+		abortODL();
+	}
+	char * path=malloc(d->value.string->length+1);
+	memcpy(path, d->value.string->text, d->value.string->length);
+	path[d->value.string->length]=0;
+	freeODL(d);
+	return path;
+}
+
+void serializeODLB(ODLList * stack, ODLDictionary * dictionary){
+	ODLData cur=popODL(stack);
+	ODLBuffer buffer={NULL, 0, 0};
+	if(!serializeODL(&buffer, &cur)){
+		fprintf(outODL, "Tried to serialize a sequence or builtin");
+		free(buffer.data);
+		freeODL(&cur);
+		abortODL();
+	}
+	freeODL(&cur);
+	cur.type=ODL_STRING;
+	cur.value.string=allocString(buffer.length);
+	memcpy(cur.value.string->data, buffer.data, buffer.length);
+	free(buffer.data);
+	pushODL(stack, cur);
+}
+
+void deserializeODLB(ODLList * stack, ODLDictionary * dictionary){
+	ODLData cur=popODL(stack);
+	if(cur.type!=ODL_STRING){
+		fprintf(outODL, "Tried deserialize with non-string");
+		freeODL(&cur);
+		abortODL();
+	}
+	ODLData d;
+	if(!deserializeODL(cur.value.string->text, cur.value.string->length, dictionary->map, &d)){
+		fprintf(outODL, "Could not deserialize");
+		freeODL(&cur);
+		abortODL();
+	}
+	freeODL(&cur);
+	pushODL(stack, d);
+}
+
+/* save "path" value writes the serialization of value to path. */
+void saveODLB(ODLList * stack, ODLDictionary * dictionary){
+	ODLData named=popODL(stack);
+	char * path=pathFromString(&named, "save");
+	ODLData cur=popODL(stack);
+	ODLBuffer buffer={NULL, 0, 0};
+	if(!serializeODL(&buffer, &cur)){
+		fprintf(outODL, "Tried to save a sequence or builtin");
+		free(buffer.data);
+		freeODL(&cur);
+		free(path);
+		abortODL();
+
+	}
+	freeODL(&cur);
+	char written=writeFileODL(path, buffer.data, buffer.length);
+	free(buffer.data);
+	if(!written){
+		fprintf(outODL, "Could not write %s", path);
+		free(path);
+		abortODL();
+	}
+	free(path);
+}
+
+/* load "path" reads back a value written by save, decoding it straight
+   out of the mapped file. */
+void loadODLB(ODLList * stack, ODLDictionary * dictionary){
+	ODLData named=popODL(stack);
+	char * path=pathFromString(&named, "load");
+	size_t length;
+	char failed;
+	char * data=mapFileODL(path, &length, &failed);
+	ODLData d;
+	char ok=!failed && deserializeODL(data, length, dictionary->map, &d);
+	if(data!=NULL){
+		munmap(data, length);
+	}
+	if(!ok){
+		if(failed){
+			fprintf(outODL, "Could not open %s", path);
+		}else{
+			fprintf(outODL, "Could not deserialize %s", path);
+		}
+		free(path);
+		abortODL();
+	}
+	free(path);
+	pushODL(stack, d);
+}
+
+/* Bulk loaders. load_ints, load_floats and load_binary map a file and return
+   a lazy sequence reading its values straight out of the mapping, so loading
+   costs the same however large the file is and only the elements actually
+   read are ever decoded. Anything that needs a list of its own forces the
+   sequence like any other. Binary values have a fixed width, so get and
+   length on load_binary index the mapping directly rather than reading up
+   to the element. The mapping is unmapped when the sequence is released. */
+typedef enum ODLBinaryKind {
+	ODL_BINARY_I8,
+	ODL_BINARY_U8,
+	ODL_BINARY_I16,
+	ODL_BINARY_U16,
+	ODL_BINARY_I32,
+	ODL_BINARY_U32,
+	ODL_BINARY_I64,
+	ODL_BINARY_F32,
+	ODL_BINARY_F64,
+} ODLBinaryKind;
+
+char * binaryKindNames[]={"i8", "u8", "i16", "u16", "i32", "u32", "i64", "f32", "f64"};
+size_t binaryKindWidths[]={1, 1, 2, 2, 4, 4, 8, 4, 8};
+
+typedef struct ODLMappedSource {
+	ODLSource source;
+	char * data;
+	size_t length;
+	char * next;
+	char * end;
+	ODLBinaryKind kind;
+} ODLMappedSource;
+
+void releaseMappedODL(ODLSource * source){
+	ODLMappedSource * mapped=(ODLMappedSource *)source;
+	if(mapped->data!=NULL){
+		munmap(mapped->data, mapped->length);
+	}
+	free(mapped);
+}
+
+/* Values are little endian whatever the host is. */
+void decodeBinaryODL(ODLBinaryKind kind, char * p, ODLData * out){
+	uint64_t v=littleEndianODL((unsigned char *)p, binaryKindWidths[kind]);
+	out->type=ODL_INT;
+	switch(kind){
+		case ODL_BINARY_I8: out->value.integer=(int8_t)v; break;
+		case ODL_BINARY_I16: out->value.integer=(int16_t)v; break;
+		case ODL_BINARY_I32: out->value.integer=(int32_t)v; break;
+		case ODL_BINARY_I64: out->value.integer=(int64_t)v; break;
+		case ODL_BINARY_F32: {
+			uint32_t bits=v;
+			float f;
+			memcpy(&f, &bits, sizeof(f));
+			out->type=ODL_NUM;
+			out->value.num=f;
+			break;
+		}
+		case ODL_BINARY_F64: {
+			double f;
+			memcpy(&f, &v, sizeof(f));
+			out->type=ODL_NUM;
+			out->value.num=f;
+			break;
+		}
+		default: out->value.integer=v; break;
+	}
+}
+
+char nextBinaryODL(ODLSource * source, ODLData * out, ODLDictionary * dictionary){
+	ODLMappedSource * mapped=(ODLMappedSource *)source;
+	size_t width=binaryKindWidths[mapped->kind];
+	if(mapped->end-mapped->next<width){
+		return 0;
+	}
+	decodeBinaryODL(mapped->kind, mapped->next, out);
+	mapped->next+=width;
+	return 1;
+}
+
+size_t remainingBinaryODL(ODLSource * source){
+	ODLMappedSource * mapped=(ODLMappedSource *)source;
+	return (mapped->end-mapped->next)/binaryKindWidths[mapped->kind];
+}
+
+void atBinaryODL(ODLSource * source, size_t index, ODLData * out){
+	ODLMappedSource * mapped=(ODLMappedSource *)source;
+	decodeBinaryODL(mapped->kind, mapped->next+index*binaryKindWidths[mapped->kind], out);
+}
+
+/* Copies the next whitespace separated token of a text file into a string
+   strtoll and strtod can stop at, since the mapping has no terminator.
+   Returns NULL at the end of the file. */
+char * nextTokenODL(ODLMappedSource * mapped, char * buffer, size_t size){
+	while(mapped->next<mapped->end && (isSpace(*mapped->next) || *mapped->next=='\r')){
+		mapped->next++;
+	}
+	if(mapped->next==mapped->end){
+		return NULL;
+	}
+	char * start=mapped->next;
+	while(mapped->next<mapped->end && !(isSpace(*mapped->next) || *mapped->next=='\r')){
+		mapped->next++;
+	}
+	size_t length=mapped->next-start;
+	char * token=length<size ? buffer : malloc(length+1);
+	memcpy(token, start, length);
+	token[length]=0;
+	return token;
+}
+
+char nextTextODL(ODLSource * source, ODLData * out, ODLDictionary * dictionary){
+	ODLMappedSource * mapped=(ODLMappedSource *)source;
+	char buffer[64];
+	char * token=nextTokenODL(mapped, buffer, sizeof(buffer));
+	if(token==NULL){
+		return 0;
+	}
+	char * end;
+	errno=0;
+	if(mapped->kind==ODL_BINARY_F64){
+		out->type=ODL_NUM;
+		out->value.num=strtod(token, &end);
+	}else{
+		out->type=ODL_INT;
+		out->value.integer=strtoll(token, &end, 10);
+		if(errno==ERANGE && *end==0){
+			*out=bigIntResult(bigIntFromString(token));
+		}
+	}
+	char bad=end==token || *end!=0;
+	if(bad){
+		fprintf(outODL, "Bad number %s", token);
+	}
+	if(token!=buffer){
+		free(token);
+	}
+	if(bad){
+		abortODL();
+	}
+	return 1;
+}
+
+ODLData mappedSeqODL(ODLData * named, char * name, char (*next)(ODLSource *, ODLData *, ODLDictionary *), ODLBinaryKind kind){
+	char * path=pathFromString(named, name);
+	size_t length;
+	char failed;
+	char * data=mapFileODL(path, &length, &failed);
+	if(failed){
+		fprintf(outODL, "Could not open %s", path);
+		free(path);
+		abortODL();
+	}
+	free(path);
+	char indexed=next==&nextBinaryODL;
+	if(data!=NULL && !indexed){
+		madvise(data, length, MADV_SEQUENTIAL);
+	}
+	ODLMappedSource * mapped=malloc(sizeof(ODLMappedSource));
+	mapped->source.next=next;
+	mapped->source.release=&releaseMappedODL;
+	mapped->source.remaining=indexed ? &remainingBinaryODL : NULL;
+	mapped->source.at=indexed ? &atBinaryODL : NULL;
+	mapped->data=data;
+	mapped->length=length;
+	mapped->next=data;
+	mapped->end=data+length;
+	mapped->kind=kind;
+	return seqValue(&mapped->source);
+}
+
+/* load_ints "path" is the whitespace separated integers in a text file. */
+void loadIntsODLB(ODLList * stack, ODLDictionary * dictionary){
+	ODLData named=popODL(stack);
+	pushODL(stack, mappedSeqODL(&named, "load_ints", &nextTextODL, ODL_BINARY_I64));
+}
+
+/* load_floats "path" is the whitespace separated numbers in a text file,
+   all as floats. */
+void loadFloatsODLB(ODLList * stack, ODLDictionary * dictionary){
+	ODLData named=popODL(stack);
+	pushODL(stack, mappedSeqODL(&named, "load_floats", &nextTextODL, ODL_BINARY_F64));
+}
+
+/* load_binary "path" "kind" is the raw little endian values in a file, where
+   kind is one of i8 u8 i16 u16 i32 u32 i64 f32 f64. A partial value at the
+   end of the file is ignored. */
+void loadBinaryODLB(ODLList * stack, ODLDictionary * dictionary){
+	ODLData named=popODL(stack);
+	ODLData kindName=popODL(stack);
+	if(kindName.type!=ODL_STRING){
+		fprintf(outODL, "Tried load_binary with non-string kind");
+		freeODL(&named);
+		freeODL(&kindName);
+		abortODL();
+	}
+	int kind=0;
+	while(kind<sizeof(binaryKindNames)/sizeof(char *) && (strlen(binaryKindNames[kind])!=kindName.value.string->length || memcmp(binaryKindNames[kind], kindName.value.string->text, kindName.value.string->length)!=0)){
+		kind++;
+	}
+	freeODL(&kindName);
+	if(kind==sizeof(binaryKindNames)/sizeof(char *)){
+		fprintf(outODL, "Unknown load_binary kind");
+		freeODL(&named);
+		abortODL();
+
+	}
+	pushODL(stack, mappedSeqODL(&named, "load_binary", &nextBinaryODL, kind));
+}
+
+/* Modules. import reads a file and registers the words it defines, found by
+   looking for define $ name in its tokens, but runs none of it: the module
+   is loaded into the top level dictionary the first time one of those words
+   is looked up and not found. The tokens of each module are cached on disk
+   keyed by a hash of its text, so an unchanged module is not tokenized
+   again. */
+
+#define ODL_CACHE_MAGIC 0x4344444f
+#define ODL_CACHE_VERSION 2
+
+typedef struct ODLModule{
+	char * path;
+	ODLList * code;
+	ODLWord * names;
+	size_t count;
+	char loaded;
+	struct ODLModule * next;
+} ODLModule;
+
+uint64_t hashODL(char * data, size_t length){
+	uint64_t hash=14695981039346656037ULL;
+	for(size_t i=0; i<length; i++){
+		hash=(hash^(unsigned char)data[i])*1099511628211ULL;
+	}
+	return hash;
+}
+
+/* ODD_CACHE, or odd under the XDG cache directory. NULL turns caching off. */
+char * cachePathODL(uint64_t hash){
+	char directory[4096];
+	char * env=getenv("ODD_CACHE");
+	if(env!=NULL){
+		if(*env==0){
+			return NULL;
+		}
+		snprintf(directory, sizeof(directory), "%s", env);
+	}else if((env=getenv("XDG_CACHE_HOME"))!=NULL && *env!=0){
+		snprintf(directory, sizeof(directory), "%s/odd", env);
+	}else if((env=getenv("HOME"))!=NULL && *env!=0){
+		snprintf(directory, sizeof(directory), "%s/.cache", env);
+		mkdir(directory, 0755);
+		snprintf(directory, sizeof(directory), "%s/.cache/odd", env);
+	}else{
+		return NULL;
+	}
+	mkdir(directory, 0755);
+
+	char * path=malloc(strlen(directory)+32);
+	sprintf(path, "%s/%016" PRIx64 ".oddc", directory, hash);
+	return path;
+}
+
+/* A cache entry is a header of the magic, the version, the hash and the
+   length of the source, followed by the serialized tokens. */
+typedef struct ODLCacheHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t hash;
+	uint64_t size;
+} ODLCacheHeader;
+
+void writeCacheODL(char * path, uint64_t hash, size_t size, ODLList * code){
+	ODLCacheHeader header={ODL_CACHE_MAGIC, ODL_CACHE_VERSION, hash, size};
+	ODLBuffer buffer={NULL, 0, 0};
+	appendODL(&buffer, (char *)&header, sizeof(header));
+	ODLData d;
+	d.type=ODL_LIST;
+	d.value.list=code;
+	if(serializeODL(&buffer, &d)){
+		writeFileODL(path, buffer.data, buffer.length);
+	}
+	free(buffer.data);
+}
+
+/* Returns the cached tokens, or NULL if there is no usable cache entry. */
+ODLList * readCacheODL(char * path, uint64_t hash, size_t size, ODLWordMap * map){
+	size_t length;
+	char failed;
+	char * data=mapFileODL(path, &length, &failed);
+	if(data==NULL){
+		return NULL;
+	}
+	ODLCacheHeader header;
+	ODLData d;
+	char ok=length>=sizeof(header);
+	if(ok){
+		memcpy(&header, data, sizeof(header));
+		ok=header.magic==ODL_CACHE_MAGIC && header.version==ODL_CACHE_VERSION && header.hash==hash && header.size==size
+			&& deserializeODL(data+sizeof(header), length-sizeof(header), map, &d);
+	}
+	munmap(data, length);
+	if(!ok){
+		return NULL;
+	}
+	if(d.type!=ODL_LIST){
+		freeODL(&d);
+		return NULL;
+	}
+	return d.value.list;
+}
+
+ODLDictionary * rootDictionary(ODLDictionary * dictionary){
+	while(dictionary->parent!=NULL){
+		dictionary=dictionary->parent;
+	}
+	return dictionary;
+}
+
+void importODLB(ODLList * stack, ODLDictionary * dictionary){
+	ODLData cur=popODL(stack);
+	if(cur.type!=ODL_STRING){
+		fprintf(outODL, "Tried import with non-string");
+		freeODL(&cur);
+		abortODL();
+	}
+	char name[cur.value.string->length+1];
+	memcpy(name, cur.value.string->text, cur.value.string->length);
+	name[cur.value.string->length]=0;
+	freeODL(&cur);
+
+	dictionary=rootDictionary(dictionary);
+	char * path=realpath(name, NULL);
+	if(path==NULL){
+		fprintf(outODL, "Could not open %s", name);
+		abortODL();
+	}
+	for(ODLModule * module=dictionary->modules; module!=NULL; module=module->next){
+		if(strcmp(module->path, path)==0){
+			free(path);
+			return;
+		}
+	}
+
+	FILE * file=fopen(path, "r");
+	if(file==NULL){
+		fprintf(outODL, "Could not open %s", name);
+		free(path);
+		abortODL();
+	}
+	fseek(file, 0, SEEK_END);
+	long size=ftell(file);
+	fseek(file, 0, SEEK_SET);
+	char * text=malloc(size+1);
+	if(size>0 && fread(text, size, 1, file)!=1){
+		fprintf(outODL, "Could not read %s", name);
+		fclose(file);
+		free(text);
+		free(path);
+		abortODL();
+	}
+	text[size]=0;
+	fclose(file);
+
+	uint64_t hash=hashODL(text, size);
+	char * cache=cachePathODL(hash);
+	ODLList * code=cache ? readCacheODL(cache, hash, size, dictionary->map) : NULL;
+	if(code==NULL){
+		ODLHold pathHold, textHold, cacheHold;
+		holdODL(&pathHold, &free, path);
+		holdODL(&textHold, &free, text);
+		holdODL(&cacheHold, &free, cache);
+		code=parseODL(text, dictionary->map);
+		unholdODL(&cacheHold);
+		unholdODL(&textHold);
+		unholdODL(&pathHold);
+		if(cache){
+			writeCacheODL(cache, hash, size, code);
+		}
+	}
+	free(cache);
+
+	free(text);
+
+	ODLModule * module=malloc(sizeof(ODLModule));
+	module->path=path;
+	module->code=code;
+	module->count=0;
+	module->names=malloc((code->top-code->bottom)/3*sizeof(ODLWord)+sizeof(ODLWord));
+	module->loaded=0;
+	for(ODLData * it=code->top; it-code->bottom>=3; it--){
+		if(it[-1].type==ODL_WORD && it[-2].type==ODL_WORD && it[-3].type==ODL_WORD
+			&& strcmp(it[-1].value.word, "define")==0 && strcmp(it[-2].value.word, "$")==0){
+			module->names[module->count++]=it[-3].value.word;
+		}
+	}
+	module->next=dictionary->modules;
+	dictionary->modules=module;
+}
+
+/* Called when name is not defined anywhere. Loads the first module waiting
+   to be loaded that defines it, if there is one, into the top level
+   dictionary. The module keeps its tokens, so that if the evaluation that
+   loaded it fails and its definitions are rolled back it can be loaded
+   again. */
+char resolveModuleODL(ODLDictionary * dictionary, ODLWord name){
+	dictionary=rootDictionary(dictionary);
+	for(ODLModule * module=dictionary->modules; module!=NULL; module=module->next){
+		if(module->loaded){
+			continue;
+		}
+		for(size_t i=0; i<module->count; i++){
+			if(module->names[i]!=name){
+				continue;
+			}
+			module->loaded=1;
+			ODLList * stack=allocList(module->code->top-module->code->bottom+1);
+			for(ODLData * it=module->code->bottom; it<module->code->top; it++){
+				pushODL(stack, copyODL(*it));
+			}
+			ODLHold hold;
+			holdODL(&hold, &releaseListODL, stack);
+			executeODL(stack, dictionary);
+			if(stack->top!=stack->bottom){
+				fprintf(outODL, "Module %s returned output:\n", module->path);
+				while(stack->top!=stack->bottom){
+					ODLData d=popODL(stack);
+					dumpODLData(d, 0);
+					freeODL(&d);
+					executeODL(stack, dictionary);
+				}
+			}
+			unholdODL(&hold);
+			freeListODL(stack);
+
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/* After a failed evaluation has rolled back definitions, any module that
+   lost one goes back to waiting to be loaded. */
+void unloadModulesODL(ODLDictionary * dictionary){
+	for(ODLModule * module=dictionary->modules; module!=NULL; module=module->next){
+		for(size_t i=0; module->loaded && i<module->count; i++){
+			ODLDefStack * entry=findEntryInDictionary(dictionary, module->names[i]);
+			if(entry==NULL || entry->code->top==entry->code->bottom){
+				module->loaded=0;
+			}
+		}
+	}
+}
+
+void freeModulesODL(ODLDictionary * dictionary){
+	while(dictionary->modules!=NULL){
+		ODLModule * module=dictionary->modules;
+		dictionary->modules=module->next;
+		freeListODL(module->code);
+		free(module->names);
+		free(module->path);
+		free(module);
+	}
+}
+
+void initDictionary(ODLDictionary * dictionary, ODLWordMap * map){
+
+	initDefsODL(dictionary, 1024);
+
+	dictionary->control.count=0;
+	dictionary->control.alloc=64;
+	dictionary->control.frames=malloc(dictionary->control.alloc*sizeof(ODLFrame));
+	initList(&dictionary->control.values, 64);
+	dictionary->parent=NULL;
+	dictionary->map=map;
+	dictionary->modules=NULL;
+	dictionary->builtins=NULL;
+
+	addBuiltin(dictionary, "carry", &carryODLB, 1, map);
+	addBuiltin(dictionary, "eval", &evalODLB, 1, map);
+	addBuiltin(dictionary, "list", &listODLB, 1, map);
+	addBuiltin(dictionary, "if", &ifODLB, 3, map);
+	addBuiltin(dictionary, "lazy_if", &lazyIfODLB, 1, map);
+	addBuiltin(dictionary, "define", &rawDefineODLB, 2, map);
+	addBuiltin(dictionary, "pop_define", &popDefineODLB, 1, map);
+	addBuiltin(dictionary, "(", &openBracketODLB, 0, map);
+	addBuiltin(dictionary, "`(", &openParsedBracketODLB, 0, map);
+	addBuiltin(dictionary, ")", &closeBracketODLB, 0, map);
+	addBuiltin(dictionary, "`", &parseODLB, 0, map);
+	addBuiltin(dictionary, "swap", &swapODLB, 2, map);
+	addBuiltin(dictionary, "+", &addODLB, 2, map);
+	addBuiltin(dictionary, "-", &minusODLB, 2, map);
+	addBuiltin(dictionary, "*", &multiplyODLB, 2, map);
+	addBuiltin(dictionary, "/", &divideODLB, 2, map);
+	addBuiltin(dictionary, "=", &equalODLB, 2, map);
+	addBuiltin(dictionary, "<", &lessThanODLB, 2, map);
+	addBuiltin(dictionary, "<=", &lessThanEqualODLB, 2, map);
+	addBuiltin(dictionary, ">", &greaterThanODLB, 2, map);
+	addBuiltin(dictionary, ">=", &greaterThanEqualODLB, 2, map);
+	addBuiltin(dictionary, "and", &andODLB, 2, map);
+	addBuiltin(dictionary, "or", &orODLB, 2, map);
+	addBuiltin(dictionary, "lazy_and", &lazyAndODLB, 1, map);
+	addBuiltin(dictionary, "lazy_or", &lazyOrODLB, 1, map);
+	addBuiltin(dictionary, "xor", &xorODLB, 2, map);
+	addBuiltin(dictionary, "dump", &dumpODLB, 0, map);
+	addBuiltin(dictionary, "mem_stats", &memStatsODLB, 0, map);
+	addBuiltin(dictionary, "bench", &benchODLB, 2, map);
+	addBuiltin(dictionary, "as_symbol", &asSymbolODLB, 0, map);
+	addBuiltin(dictionary, "$", &asSymbolODLB, 0, map);
+	addBuiltin(dictionary, "as_word", &asWordODLB, 1, map);
+	addBuiltin(dictionary, "@", &asWordODLB, 1, map);
+	addBuiltin(dictionary, "push", &pushODLB, 2, map);
+	addBuiltin(dictionary, "merge", &pushListODLB, 2, map);
+	addBuiltin(dictionary, "pop", &popODLB, 1, map);
+	addBuiltin(dictionary, "peek", &peekODLB, 1, map);
+	addBuiltin(dictionary, "unshift", &unshiftODLB, 2, map);
+	addBuiltin(dictionary, "rest", &restODLB, 1, map);
+	addBuiltin(dictionary, "duplicate", &duplicateODLB, 1, map);
+	addBuiltin(dictionary, "copy", &copyODLB, 1, map);
+	addBuiltin(dictionary, "get", &getODLB, 2, map);
+	addBuiltin(dictionary, "length", &lengthODLB, 1, map);
+	addBuiltin(dictionary, "discard", &discardODLB, 1, map);
+	addBuiltin(dictionary, "empty", &emptyODLB, 1, map);
+	addBuiltin(dictionary, "for_each", &forEachODLB, 3, map);
+	addBuiltin(dictionary, "read_lines", &readLinesODLB, 1, map);
+	addBuiltin(dictionary, "range", &rangeODLB, 2, map);
+	addBuiltin(dictionary, "iterate", &iterateODLB, 2, map);
+	addBuiltin(dictionary, "generate", &generateODLB, 2, map);
+	addBuiltin(dictionary, "map", &mapODLB, 1, map);
+	addBuiltin(dictionary, "filter", &filterODLB, 1, map);
+	addBuiltin(dictionary, "spawn", &spawnODLB, 1, map);
+	addBuiltin(dictionary, "join", &joinODLB, 1, map);
+	addBuiltin(dictionary, "import", &importODLB, 1, map);
+	addBuiltin(dictionary, "effect", &effectODLB, 1, map);
+	addBuiltin(dictionary, "sort", &sortODLB, 1, map);
+	addBuiltin(dictionary, "sort_by", &sortByODLB, 2, map);
+	addBuiltin(dictionary, "binary_search", &binarySearchODLB, 2, map);
+	addBuiltin(dictionary, "unique", &uniqueODLB, 1, map);
+	addBuiltin(dictionary, "new_map", &newMapODLB, 0, map);
+	addBuiltin(dictionary, "insert", &insertODLB, 3, map);
+	addBuiltin(dictionary, "lookup", &lookupODLB, 2, map);
+	addBuiltin(dictionary, "has", &hasODLB, 2, map);
+	addBuiltin(dictionary, "remove", &removeODLB, 2, map);
+	addBuiltin(dictionary, "keys", &keysODLB, 1, map);
+	addBuiltin(dictionary, "serialize", &serializeODLB, 1, map);
+	addBuiltin(dictionary, "deserialize", &deserializeODLB, 1, map);
+	addBuiltin(dictionary, "save", &saveODLB, 2, map);
+	addBuiltin(dictionary, "load", &loadODLB, 1, map);
+	addBuiltin(dictionary, "load_ints", &loadIntsODLB, 1, map);
+	addBuiltin(dictionary, "load_floats", &loadFloatsODLB, 1, map);
+	addBuiltin(dictionary, "load_binary", &loadBinaryODLB, 2, map);
+}
+
+/* Undoes what an aborted evaluation left behind: its frames and their
+   values, and anything it pushed onto the dictionary. depths holds the depth
+   of the first count entries when it started. */
+void recoverODLState(ODLDictionary * dictionary, size_t * depths, size_t count){
+	ODLControl * control=&dictionary->control;
+	while(control->count>0){
+		ODLFrame * frame=control->frames+--control->count;
+		if(frame->release!=NULL){
+			frame->release(frame->state);
+		}
+	}
+	while(control->values.top>control->values.bottom){
+		control->values.top--;
+		freeODL(control->values.top);
+	}
+	for(size_t i=0; i<dictionary->count; i++){
+		popDefinitionsODL(dictionary, entryAtODL(dictionary, i), i<count ? depths[i] : 0);
+	}
+	unloadModulesODL(dictionary);
+}
+
+/* Dumps and frees the values on the stack, top first, carrying on with
+   whatever is under each one. */
+void dumpStackODL(ODLList * stack, ODLDictionary * dictionary){
+	while(stack->top!=stack->bottom){
+		ODLData d=popODL(stack);
+		dumpODLData(d, 0);
+		freeODL(&d);
+
+		executeODL(stack, dictionary);
+	}
+}
+
+typedef void (*ODLStatement)(ODLList * stack, ODLDictionary * dictionary);
+
+/* Evaluates one statement, dumping whatever it leaves on the stack: a line
+   of the REPL, or for a compiled program a statement that puts its code or
+   values on the stack itself and may run builtins of its own first. An error
+   or going over the heap limit abandons just this statement. Once
+   dictionaries are shared the thread is pinned for the statement, so what
+   it looks up stays put until the statement is done. */
+void evaluateStatementODL(char * line, ODLStatement statement, ODLDictionary * dictionary, ODLWordMap * map){
+	if(sharedODL){
+		pinODL();
+	}
+	size_t count=dictionary->count;
+	size_t * depths=malloc((count+1)*sizeof(size_t));
+	for(size_t i=0; i<count; i++){
+		ODLList * code=entryAtODL(dictionary, i)->code;
+		depths[i]=code->top-code->bottom;
+	}
+
+	ODLList * volatile stack=NULL;
+	jmp_buf recover;
+	if(setjmp(recover)==0){
+		recoverODL=&recover;
+		startEvaluationODL();
+		size_t base=dictionary->control.count;
+		if(statement!=NULL){
+			stack=allocList(16);
+			statement(stack, dictionary);
+		}else{
+			stack=parseODL(line, map);
+		}
+		runODL(stack, dictionary, base, SIZE_MAX);
+		dumpStackODL(stack, dictionary);
+	}else{
+		fprintf(outODL, "\n");
+		recoverODLState(dictionary, depths, count);
+	}
+	recoverODL=NULL;
+	if(stack!=NULL){
+		freeListODL(stack);
+	}
+	free(depths);
+	if(sharedODL){
+		unpinODL();
+		reclaimODL();
+	}
+}
+
+void evaluateODL(char * line, ODLDictionary * dictionary, ODLWordMap * map){
+	evaluateStatementODL(line, NULL, dictionary, map);
+}
+
+void freeDictionaryODL(ODLDictionary * dictionary){
+	if(dictionary->shared){
+		synchronizeODL();
+	}
+	freeModulesODL(dictionary);
+	for(size_t i=0; i<dictionary->count; i++){
+		ODLDefStack * entry=dictionary->defs->entries[i];
+		freeDefinitionsODL(entry->code);
+		if(entry->jit){
+			releaseJit(entry->jit);
+		}
+		if(entry->typed){
+			freeTypedODL(entry->typed);
+		}
+		free(entry);
+	}
+	free(dictionary->defs);
+	pthread_mutex_destroy(&dictionary->lock);
+	free(dictionary->control.frames);
+	free(dictionary->control.values.base);
+	while(dictionary->builtins!=NULL){
+		ODLBuiltinDef * next=dictionary->builtins->next;
+		free(dictionary->builtins);
+		dictionary->builtins=next;
+	}
+	free(dictionary);
+
+}
+
+void freeWordMapODL(ODLWordMap * map){
+	for(size_t i=0; i<map->count; i++){
+		free(map->wordList[i]);
+	}
+	free(map->wordList);
+}
+
+char * readStdlibODL(){
+	FILE* fd=fopen("./lib/std.odd", "r");
+	
+	fseek(fd, 0, SEEK_END);
+	int size=ftell(fd);
+
+	char * lib=malloc(size+1);
+	memset(lib, 0, size+1);
+	fseek(fd, 0, SEEK_SET);
+	if(!fread(lib, size, 1, fd)){
+		printf("Could not read stdlib %d\n", size);
+		exit(1);
+	}
+	fclose(fd);
+	return lib;
+}
+
+ODLDictionary * newDictionaryODL(ODLWordMap * map){
+	map->count=0;
+	map->alloc=1024;
+	map->wordList=malloc(map->alloc*sizeof(ODLWord));
+
+	ODLDictionary * dictionary=malloc(sizeof(ODLDictionary));
+
+	initDictionary(dictionary, map);
+	return dictionary;
+}
+
+/* Runs the standard library, already on the stack as code. */
+void runStdlibODL(ODLList * stack, ODLDictionary * dictionary){
+	executeODL(stack, dictionary);
+
+	if(stack->top!=stack->bottom){
+		fprintf(outODL, "Standard library returned output:\n");
+	
+		while(stack->top!=stack->bottom){
+			ODLData d=popODL(stack);
+			dumpODLData(d, 0);
+	
+			executeODL(stack, dictionary);
+		}
+	}
+	
+	freeListODL(stack);
+}
+
+ODLDictionary * bootODL(ODLWordMap * map, char * lib){
+	ODLDictionary * dictionary=newDictionaryODL(map);
+	runStdlibODL(parseODL(lib, map), dictionary);
+	return dictionary;
+}
+
+/* Ahead of time compilation. odd --compile prog.odd writes out C for a native
+   build of prog.odd, which runs its lines the way the REPL would, without the
+   prompts. The program and the standard library are tokenized at compile
+   time into a table that the values the program uses are built from once at
+   start up. A line made only of builtins and literals becomes C calling the
+   builtins directly, its arguments worked out before each call; anything
+   else is kept as code for the evaluator. A builtin is only called directly
+   if its name is never quoted with $ in the program or the standard library,
+   since quoting is how a name gets defined, and only if the program cannot
+   bring in code the compiler never saw, through import, load or deserialize.
+   By the same rule a definition whose name is only quoted where it is
+   defined, at the top level of the standard library or of a define line, is
+   static: it is resolved at compile time by splicing its body into the lines
+   that call it, so they compile to builtin calls too. Only names defined
+   dynamically, or reached through @ or code held as a list, are left to the
+   dictionary. */
+
+typedef struct ODLCompiledToken {
+	ODLDataType type;
+	ODLInt integer;
+	ODLNum num;
+	char * text;
+	size_t length;
+} ODLCompiledToken;
+
+/* A value of a compiled program: the token at first, or the list of the
+   count elements from first. A list token is followed by as many elements
+   as its integer, each of them one token or another list. */
+typedef struct ODLCompiledValue {
+	size_t first;
+	size_t count;
+	char list;
+} ODLCompiledValue;
+
+/* The first value is the standard library. A statement is compiled code, or
+   if its line could not even be tokenized, the line itself, so that it fails
+   the same way when the program runs. */
+typedef struct ODLCompiledProgram {
+	ODLCompiledToken * tokens;
+	ODLCompiledValue * values;
+	size_t valueCount;
+	ODLData * built;
+	ODLStatement * statements;
+	char ** sources;
+	size_t statementCount;
+} ODLCompiledProgram;
+
+/* Builds the element at *token, moving *token past it. */
+ODLData compiledTokenODL(ODLCompiledToken ** tokens, ODLWordMap * map){
+	ODLCompiledToken * token=(*tokens)++;
+	ODLData d;
+	d.type=token->type;
+	switch(token->type){
+		case ODL_LIST:
+			d.value.list=allocList(token->integer);
+			for(ODLInt i=0; i<token->integer; i++){
+				pushODL(d.value.list, compiledTokenODL(tokens, map));
+			}
+			break;
+		case ODL_WORD:
+		case ODL_SYMBOL:
+			d.value.word=findInWordMap(token->text, map);
+			break;
+		case ODL_INT:
+			d.value.integer=token->integer;
+			break;
+		case ODL_NUM:
+			d.value.num=token->num;
+			break;
+		case ODL_STRING:
+			d.value.string=allocString(token->length);
+			memcpy(d.value.string->data, token->text, token->length);
+			break;
+		default:
+			d=bigIntResult(bigIntFromString(token->text));
+	}
+	return d;
+}
+
+/* Reverses the top count values, so that arguments worked out first to last
+   end up first topmost. */
+void flipODL(ODLList * stack, int count){
+	ODLData * bottom=stack->top-count;
+	ODLData * top=stack->top-1;
+	while(top>bottom){
+		ODLData temp=*top;
+		*top=*bottom;
+		*bottom=temp;
+		top--;
+		bottom++;
+	}
+}
+
+int runCompiledODL(ODLCompiledProgram * program){
+	outODL=stdout;
+	ODLWordMap map;
+	ODLDictionary * dictionary=newDictionaryODL(&map);
+
+	for(size_t i=0; i<program->valueCount; i++){
+		ODLCompiledValue * value=program->values+i;
+		ODLCompiledToken * token=program->tokens+value->first;
+		if(!value->list){
+			program->built[i]=compiledTokenODL(&token, &map);
+			continue;
+		}
+		ODLData d;
+		d.type=ODL_LIST;
+		d.value.list=allocList(value->count);
+		for(size_t j=0; j<value->count; j++){
+			pushODL(d.value.list, compiledTokenODL(&token, &map));
+		}
+		program->built[i]=d;
+	}
+
+	ODLList * stack=allocList(16);
+	pushODL(stack, copyODL(program->built[0]));
+	unrollODL(stack, dictionary);
+	runStdlibODL(stack, dictionary);
+
+	for(size_t i=0; i<program->statementCount; i++){
+		if(program->statements[i]!=NULL){
+			evaluateStatementODL(NULL, program->statements[i], dictionary, &map);
+			continue;
+		}
+		char * line=strdup(program->sources[i]);
+		evaluateStatementODL(line, NULL, dictionary, &map);
+		free(line);
+	}
+
+	for(size_t i=0; i<program->valueCount; i++){
+		freeODL(program->built+i);
+	}
+	freeFibersODL();
+	freeDictionaryODL(dictionary);
+	freeWordMapODL(&map);
+	freeListPoolODL();
+	return 0;
+}
+
+/* A static definition and what it stands for from just after line on, 0
+   being the standard library. */
+typedef struct ODLStaticDef {
+	ODLWord name;
+	ODLData value;
+	size_t line;
+} ODLStaticDef;
+
+typedef struct ODLCompiler {
+	ODLDictionary * dictionary;
+	ODLList * tokens;
+	ODLCompiledValue * values;
+	size_t valueCount;
+	size_t valueAlloc;
+	ODLWord * quoted;
+	size_t quotedCount;
+	char direct;
+	ODLStaticDef * statics;
+	size_t staticCount;
+	size_t line;
+	ODLBuffer code;
+} ODLCompiler;
+
+void addTokensODL(ODLCompiler * c, ODLData * tokens, size_t count){
+	for(size_t i=0; i<count; i++){
+		pushODL(c->tokens, copyODL(tokens[i]));
+		if(tokens[i].type==ODL_LIST){
+			ODLList * elements=tokens[i].value.list;
+			addTokensODL(c, elements->bottom, elements->top-elements->bottom);
+		}
+	}
+}
+
+size_t addValueODL(ODLCompiler * c, ODLData * tokens, size_t count, char list){
+	if(c->valueCount>=c->valueAlloc){
+		c->valueAlloc=c->valueAlloc ? c->valueAlloc*2 : 64;
+		c->values=realloc(c->values, c->valueAlloc*sizeof(ODLCompiledValue));
+	}
+	ODLCompiledValue * value=c->values+c->valueCount;
+	value->first=c->tokens->top-c->tokens->bottom;
+	value->count=count;
+	value->list=list;
+	addTokensODL(c, tokens, count);
+	return c->valueCount++;
+}
+
+void pushValueCodeODL(ODLCompiler * c, size_t value){
+	char line[64];
+	snprintf(line, sizeof(line), "\tpushODL(stack, copyODL(odlBuilt[%zu]));\n", value);
+	appendTextODL(&c->code, line);
+}
+
+/* The builtin a token is bound to at compile time, if it is a word bound to
+   one. */
+ODLBuiltinDef * compiledBuiltinODL(ODLCompiler * c, ODLData * token){
+	if(token->type!=ODL_WORD){
+		return NULL;
+	}
+	ODLDefStack * entry=findEntryInDictionary(c->dictionary, token->value.word);
+	if(entry==NULL || entry->code->top==entry->code->bottom || (entry->code->top-1)->type!=ODL_BUILTIN){
+		return NULL;
+	}
+	return (entry->code->top-1)->value.builtin;
+}
+
+void scanQuotesODL(ODLCompiler * c, ODLData * tokens, size_t count){
+	for(size_t i=0; i<count; i++){
+		ODLBuiltinDef * builtin=compiledBuiltinODL(c, tokens+i);
+		if(builtin==NULL){
+			continue;
+		}
+		if(builtin->call==&importODLB || builtin->call==&loadODLB || builtin->call==&deserializeODLB){
+			c->direct=0;
+		}
+		if(builtin->call==&asSymbolODLB && i+1<count && tokens[i+1].type==ODL_WORD){
+			c->quoted=realloc(c->quoted, (c->quotedCount+1)*sizeof(ODLWord));
+			c->quoted[c->quotedCount++]=tokens[i+1].value.word;
+		}
+	}
+}
+
+char directODL(ODLCompiler * c, ODLWord word){
+	for(size_t i=0; i<c->quotedCount; i++){
+		if(c->quoted[i]==word){
+			return 0;
+		}
+	}
+	return c->direct;
+}
+
+size_t quoteCountODL(ODLCompiler * c, ODLWord word){
+	size_t count=0;
+	for(size_t i=0; i<c->quotedCount; i++){
+		count+=c->quoted[i]==word;
+	}
+	return count;
+}
+
+/* Whether a value can go in the token table: a token the parser could have
+   made, or a list of them. */
+char tokenValueODL(ODLData * d){
+	if(d->type==ODL_LIST){
+		for(ODLData * it=d->value.list->bottom; it<d->value.list->top; it++){
+			if(!tokenValueODL(it)){
+				return 0;
+			}
+		}
+		return 1;
+	}
+	return d->type==ODL_WORD || d->type==ODL_SYMBOL || d->type==ODL_INT || d->type==ODL_NUM
+		|| d->type==ODL_STRING || d->type==ODL_BIGINT;
+}
+
+void addStaticODL(ODLCompiler * c, ODLDefStack * entry, size_t line){
+	ODLData * value=entry->code->top-1;
+	if(entry->code->top-entry->code->bottom!=1 || !tokenValueODL(value)){
+		return;
+	}
+	c->statics=realloc(c->statics, (c->staticCount+1)*sizeof(ODLStaticDef));
+	ODLStaticDef * def=c->statics+c->staticCount++;
+	def->name=entry->name;
+	def->value=copyODL(*value);
+	def->line=line;
+}
+
+/* The static definition a token resolves to in the line being compiled. */
+ODLStaticDef * staticDefinitionODL(ODLCompiler * c, ODLData * token){
+	if(token->type!=ODL_WORD){
+		return NULL;
+	}
+	for(size_t i=0; i<c->staticCount; i++){
+		if(c->statics[i].name==token->value.word && c->statics[i].line<c->line){
+			return c->statics+i;
+		}
+	}
+	return NULL;
+}
+
+/* Adds the definitions the standard library makes at its top level, with
+   define or function, of names quoted nowhere else. */
+void stdlibStaticsODL(ODLCompiler * c, ODLData * tokens, size_t count){
+	int depth=0;
+	for(size_t i=0; i+2<count && c->direct; i++){
+		if(isWordODL(tokens+i, "(") || isWordODL(tokens+i, "`(")){
+			depth++;
+		}else if(isWordODL(tokens+i, ")")){
+			depth--;
+		}else if(depth==0 && (isWordODL(tokens+i, "define") || isWordODL(tokens+i, "function"))
+			&& isWordODL(tokens+i+1, "$") && tokens[i+2].type==ODL_WORD && quoteCountODL(c, tokens[i+2].value.word)==1){
+			ODLDefStack * entry=findEntryInDictionary(c->dictionary, tokens[i+2].value.word);
+			if(entry!=NULL){
+				addStaticODL(c, entry, 0);
+			}
+		}
+	}
+}
+
+/* Whether a line is define $ name followed by a bracket or a literal, of a
+   name quoted nowhere else and not defined yet. Such a line can only fail if
+   its body is rejected when it is defined, which depends on nothing that can
+   change while the program runs as long as the words at the top level of
+   the body are builtins called directly or static definitions. */
+char staticDefineODL(ODLCompiler * c, ODLData * tokens, size_t count){
+	ODLBuiltinDef * head=compiledBuiltinODL(c, tokens);
+	ODLBuiltinDef * quote=count>3 ? compiledBuiltinODL(c, tokens+1) : NULL;
+	if(head==NULL || head->call!=&rawDefineODLB || !directODL(c, tokens[0].value.word)
+		|| quote==NULL || quote->call!=&asSymbolODLB || !directODL(c, tokens[1].value.word)
+		|| tokens[2].type!=ODL_WORD || quoteCountODL(c, tokens[2].value.word)!=1){
+		return 0;
+	}
+	ODLDefStack * entry=findEntryInDictionary(c->dictionary, tokens[2].value.word);
+	if(entry!=NULL && entry->code->top>entry->code->bottom){
+		return 0;
+	}
+	if(count==4){
+		return tokens[3].type!=ODL_WORD;
+	}
+	ODLBuiltinDef * bracket=compiledBuiltinODL(c, tokens+3);
+	if(bracket==NULL || bracket->call!=&openBracketODLB || !directODL(c, tokens[3].value.word)
+		|| matchBracketODL(tokens, 3, count)!=count){
+		return 0;
+	}
+	for(size_t i=4; i<count-1; i++){
+		ODLBuiltinDef * builtin=compiledBuiltinODL(c, tokens+i);
+		if(tokens[i].type==ODL_WORD && staticDefinitionODL(c, tokens+i)==NULL
+			&& (builtin==NULL || !directODL(c, tokens[i].value.word))){
+			return 0;
+		}
+		if(builtin!=NULL && (builtin->call==&openBracketODLB || builtin->call==&openParsedBracketODLB)){
+			size_t end=matchBracketODL(tokens, i, count);
+			if(end==0){
+				return 0;
+			}
+			i=end-1;
+		}else if(builtin!=NULL && builtin->call==&asSymbolODLB){
+			i++;
+		}
+	}
+	return 1;
+}
+
+/* How many tokens from the top of pending the evaluator is sure to take as
+   code and values, without reading what comes after them: a literal, a
+   builtin with a signature, which only takes evaluated arguments, $ and the
+   token it quotes, or a whole bracket. 0 for anything else. */
+size_t codeExtentODL(ODLCompiler * c, ODLList * pending){
+	ODLData * next=pending->top-1;
+	ODLBuiltinDef * builtin=NULL;
+	if(next->type==ODL_BUILTIN){
+		builtin=next->value.builtin;
+	}else if(next->type==ODL_WORD){
+		builtin=compiledBuiltinODL(c, next);
+		if(builtin==NULL || !directODL(c, next->value.word)){
+			return 0;
+		}
+	}else{
+		return 1;
+	}
+	if(builtin->call==&asSymbolODLB){
+		return next>pending->bottom ? 2 : 0;
+	}
+	if(builtin->call==&openBracketODLB){
+		int depth=1;
+		for(ODLData * it=next-1; it>=pending->bottom; it--){
+			if(isWordODL(it, "(") || isWordODL(it, "`(")){
+				depth++;
+			}else if(isWordODL(it, ")") && --depth==0){
+				return next-it+1;
+			}else if(depth==1 && isWordODL(it, "`")){
+				return 0;
+			}
+		}
+		return 0;
+	}
+	return findSignature(builtin->call)!=NULL;
+}
+
+#define ODL_MAX_SPLICES 64
+
+/* The tokens of a line with the static definitions it calls spliced in, as
+   the evaluator would unroll them on getting to them. Only tokens sure to be
+   reached as code are looked at: at the first one that is not, such as a
+   word left to the dictionary or a builtin that reads the tokens after it
+   itself, the rest of the line is kept as it is. Brackets are kept as they
+   are too, as what is in them is a list until something runs it. */
+ODLList * spliceStaticsODL(ODLCompiler * c, ODLData * tokens, size_t count){
+	ODLList * pending=allocList(count);
+	for(size_t i=count; i>0; i--){
+		pushODL(pending, copyODL(tokens[i-1]));
+	}
+	ODLList * line=allocList(count);
+	int splices=0;
+	while(pending->top>pending->bottom){
+		ODLStaticDef * def=staticDefinitionODL(c, pending->top-1);
+		if(def!=NULL && splices<ODL_MAX_SPLICES){
+			ODLData word=popODL(pending);
+			freeODL(&word);
+			pushODL(pending, copyODL(def->value));
+			unrollODL(pending, c->dictionary);
+			splices++;
+			continue;
+		}
+		size_t extent=codeExtentODL(c, pending);
+		if(extent==0){
+			extent=pending->top-pending->bottom;
+		}
+		while(extent-->0){
+			pushODL(line, popODL(pending));
+		}
+	}
+	freeListODL(pending);
+	return line;
+}
+
+/* Compiles the expression at tokens[*i] into code leaving its value on the
+   stack, moving *i past it. Returns 0 if it is not made of builtins called
+   directly and literals alone. An argument has to be a builtin with a
+   signature, which is known to take only its arguments and leave one value;
+   only the outermost call of a line may be any builtin. */
+char compileExpressionODL(ODLCompiler * c, ODLData * tokens, size_t count, size_t * i, char argument){
+	if(*i>=count){
+		return 0;
+	}
+	ODLData * token=tokens+*i;
+	if(token->type!=ODL_WORD){
+		pushValueCodeODL(c, addValueODL(c, token, 1, 0));
+		(*i)++;
+		return 1;
+	}
+	ODLBuiltinDef * builtin=compiledBuiltinODL(c, token);
+	if(builtin==NULL || !directODL(c, token->value.word)){
+		return 0;
+	}
+	if(builtin->call==&asSymbolODLB){
+		if(*i+1>=count){
+			return 0;
+		}
+		ODLData quoted=tokens[*i+1];
+		if(quoted.type==ODL_WORD){
+			quoted.type=ODL_SYMBOL;
+		}
+		pushValueCodeODL(c, addValueODL(c, &quoted, 1, 0));
+		*i+=2;
+		return 1;
+	}
+	if(builtin->call==&openBracketODLB){
+		size_t end=*i+1;
+		int depth=1;
+		for(; end<count; end++){
+			if(tokens[end].type!=ODL_WORD){
+				continue;
+			}
+			char * word=tokens[end].value.word;
+			if(strcmp(word, "(")==0 || strcmp(word, "`(")==0){
+				depth++;
+			}else if(strcmp(word, ")")==0 && --depth==0){
+				break;
+			}else if(depth==1 && strcmp(word, "`")==0){
+				return 0;
+			}
+		}
+		if(end==count){
+			return 0;
+		}
+		pushValueCodeODL(c, addValueODL(c, tokens+*i+1, end-*i-1, 1));
+		*i=end+1;
+		return 1;
+	}
+	if(builtin->call==&openParsedBracketODLB || builtin->call==&closeBracketODLB || builtin->call==&parseODLB
+		|| builtin->symbol==NULL || (argument && findSignature(builtin->call)==NULL)){
+		return 0;
+	}
+	(*i)++;
+	for(int k=0; k<builtin->arity; k++){
+		if(!compileExpressionODL(c, tokens, count, i, 1)){
+			return 0;
+		}
+	}
+	char line[128];
+	if(builtin->arity>1){
+		snprintf(line, sizeof(line), "\tflipODL(stack, %d);\n", builtin->arity);
+		appendTextODL(&c->code, line);
+	}
+	snprintf(line, sizeof(line), "\t%s(stack, dictionary);\n", builtin->symbol);
+	appendTextODL(&c->code, line);
+	return 1;
+}
+
+/* Each expression of a line is dumped before the next one runs, as in the
+   REPL, so every one but the last has to leave exactly one value. */
+char compileStatementODL(ODLCompiler * c, ODLData * tokens, size_t count){
+	size_t i=0;
+	while(i<count){
+		ODLData * first=tokens+i;
+		if(!compileExpressionODL(c, tokens, count, &i, 0)){
+			return 0;
+		}
+		if(i==count){
+			break;
+		}
+		ODLBuiltinDef * builtin=compiledBuiltinODL(c, first);
+		if(builtin!=NULL && builtin->call!=&asSymbolODLB && builtin->call!=&openBracketODLB && findSignature(builtin->call)==NULL){
+			return 0;
+		}
+		appendTextODL(&c->code, "\tdumpStackODL(stack, dictionary);\n");
+	}
+	return 1;
+}
+
+/* Writes text as a C string literal, escaping anything but plain printable
+   characters so that nothing in it can end the literal or start a trigraph. */
+void printCStringODL(char * text, size_t length){
+	putchar('"');
+	for(size_t i=0; i<length; i++){
+		unsigned char ch=text[i];
+		if(ch>=' ' && ch<='~' && ch!='"' && ch!='\\' && ch!='?'){
+			putchar(ch);
+		}else{
+			printf("\\%03o", ch);
+		}
+	}
+	putchar('"');
+}
+
+void printCompiledTokenODL(ODLData * token){
+	char * types[]={"ODL_ERROR", "ODL_WORD", "ODL_NUM", "ODL_LIST", "ODL_OBJECT", "ODL_STRING", "ODL_INT", "ODL_BUILTIN", "ODL_SYMBOL", "ODL_BIGINT"};
+	printf("\t{%s, ", types[token->type]);
+	if(token->type==ODL_LIST){
+		printf("%zu, 0, NULL, 0},\n", (size_t)(token->value.list->top-token->value.list->bottom));
+	}else if(token->type==ODL_INT && token->value.integer==INT64_MIN){
+		printf("INT64_MIN, 0, NULL, 0},\n");
+	}else if(token->type==ODL_INT){
+		printf("%" PRId64 "LL, 0, NULL, 0},\n", token->value.integer);
+	}else if(token->type==ODL_NUM && isinf(token->value.num)){
+		printf("0, %s__builtin_inf(), NULL, 0},\n", token->value.num<0 ? "-" : "");
+	}else if(token->type==ODL_NUM){
+		printf("0, %a, NULL, 0},\n", token->value.num);
+	}else if(token->type==ODL_STRING){
+		printf("0, 0, ");
+		printCStringODL(token->value.string->text, token->value.string->length);
+		printf(", %zu},\n", token->value.string->length);
+	}else if(token->type==ODL_BIGINT){
+		char * text=bigIntToString(token->value.bigint);
+		printf("0, 0, \"%s\", 0},\n", text);
+		free(text);
+	}else{
+		printf("0, 0, ");
+		printCStringODL(token->value.word, strlen(token->value.word));
+		printf(", 0},\n");
+	}
+}
+
+/* Parses one line for the compiler, in the order it was written. Returns
+   NULL if it does not tokenize. */
+ODLList * compileParseODL(char * line, ODLWordMap * map){
+	ODLList * volatile tokens=NULL;
+	jmp_buf recover;
+	if(setjmp(recover)==0){
+		recoverODL=&recover;
+		tokens=parseODL(line, map);
+		reverseODL(tokens);
+	}
+	recoverODL=NULL;
+	return tokens;
+}
+
+int compileODL(char * path, char * lib){
+	FILE * file=fopen(path, "r");
+	if(file==NULL){
+		fprintf(stderr, "Could not open %s\n", path);
+		return 1;
+	}
+	outODL=stderr;
+
+	ODLWordMap map;
+	ODLCompiler c;
+	c.dictionary=bootODL(&map, lib);
+	c.tokens=allocList(1024);
+	c.values=NULL;
+	c.valueCount=0;
+	c.valueAlloc=0;
+	c.quoted=NULL;
+	c.quotedCount=0;
+	c.direct=1;
+	c.statics=NULL;
+	c.staticCount=0;
+	c.line=0;
+	c.code.data=NULL;
+	c.code.length=0;
+	c.code.alloc=0;
+
+	ODLList * stdlib=compileParseODL(lib, &map);
+	addValueODL(&c, stdlib->bottom, stdlib->top-stdlib->bottom, 1);
+	scanQuotesODL(&c, stdlib->bottom, stdlib->top-stdlib->bottom);
+
+	size_t count=0;
+	size_t number=0;
+	size_t alloc=64;
+	ODLList ** lines=malloc(alloc*sizeof(ODLList *));
+	char ** sources=malloc(alloc*sizeof(char *));
+	char * buffer=NULL;
+	size_t bufsize=0;
+	ssize_t length;
+	while((length=getline(&buffer, &bufsize, file))>=0){
+		if(count>=alloc){
+			alloc*=2;
+			lines=realloc(lines, alloc*sizeof(ODLList *));
+			sources=realloc(sources, alloc*sizeof(char *));
+		}
+		if(length>0 && buffer[length-1]=='\n'){
+			buffer[--length]=0;
+		}
+		sources[count]=strdup(buffer);
+		lines[count]=compileParseODL(buffer, &map);
+		number++;
+		if(lines[count]==NULL){
+			fprintf(stderr, " on line %zu, left to fail when run\n", number);
+		}else{
+			scanQuotesODL(&c, lines[count]->bottom, lines[count]->top-lines[count]->bottom);
+			if(lines[count]->top==lines[count]->bottom){
+				freeListODL(lines[count]);
+				free(sources[count]);
+				continue;
+			}
+		}
+		count++;
+	}
+	free(buffer);
+	fclose(file);
+
+	stdlibStaticsODL(&c, stdlib->bottom, stdlib->top-stdlib->bottom);
+	freeListODL(stdlib);
+
+	ODLBuffer functions={NULL, 0, 0};
+	for(size_t i=0; i<count; i++){
+		if(lines[i]==NULL){
+			continue;
+		}
+		c.line=i+1;
+		if(c.direct && staticDefineODL(&c, lines[i]->bottom, lines[i]->top-lines[i]->bottom)){
+			char * line=strdup(sources[i]);
+			evaluateODL(line, c.dictionary, &map);
+			free(line);
+			addStaticODL(&c, findEntryInDictionary(c.dictionary, lines[i]->bottom[2].value.word), i+1);
+		}
+		ODLList * spliced=spliceStaticsODL(&c, lines[i]->bottom, lines[i]->top-lines[i]->bottom);
+		ODLData * tokens=spliced->bottom;
+		size_t size=spliced->top-spliced->bottom;
+		size_t valueCount=c.valueCount;
+		size_t tokenCount=c.tokens->top-c.tokens->bottom;
+		c.code.length=0;
+		if(!compileStatementODL(&c, tokens, size)){
+			c.valueCount=valueCount;
+			while(c.tokens->top-c.tokens->bottom>tokenCount){
+				c.tokens->top--;
+				freeODL(c.tokens->top);
+			}
+			c.code.length=0;
+			pushValueCodeODL(&c, addValueODL(&c, tokens, size, 1));
+			appendTextODL(&c.code, "\tunrollODL(stack, dictionary);\n");
+		}
+		char line[96];
+		snprintf(line, sizeof(line), "static void statement%zu(ODLList * stack, ODLDictionary * dictionary){\n", i);
+		appendTextODL(&functions, line);
+		appendODL(&functions, c.code.data, c.code.length);
+		appendTextODL(&functions, "}\n\n");
+		freeListODL(spliced);
+		freeListODL(lines[i]);
+	}
+
+	printf("/* Compiled from %s by odd --compile. */\n\n#define ODL_COMPILED\n#include \"odd.c\"\n\n", path);
+	printf("static ODLData odlBuilt[%zu];\n\n", c.valueCount);
+	fwrite(functions.data, 1, functions.length, stdout);
+	free(functions.data);
+	printf("static ODLCompiledToken odlTokens[]={\n");
+	for(ODLData * it=c.tokens->bottom; it<c.tokens->top; it++){
+		printCompiledTokenODL(it);
+	}
+	printf("};\n\nstatic ODLCompiledValue odlValues[]={\n");
+	for(size_t i=0; i<c.valueCount; i++){
+		printf("\t{%zu, %zu, %d},\n", c.values[i].first, c.values[i].count, c.values[i].list);
+	}
+	printf("};\n\nstatic ODLStatement odlStatements[]={\n");
+	for(size_t i=0; i<count; i++){
+		if(lines[i]==NULL){
+			printf("\tNULL,\n");
+		}else{
+			printf("\t&statement%zu,\n", i);
+		}
+	}
+	printf("\tNULL\n};\n\nstatic char * odlSources[]={\n");
+	for(size_t i=0; i<count; i++){
+		printf("\t");
+		if(lines[i]==NULL){
+			printCStringODL(sources[i], strlen(sources[i]));
+		}else{
+			printf("NULL");
+		}
+		printf(",\n");
+		free(sources[i]);
+	}
+	printf("\tNULL\n};\n\n");
+	printf("int main(int argc, char ** argv){\n");
+	printf("\tODLCompiledProgram program={odlTokens, odlValues, %zu, odlBuilt, odlStatements, odlSources, %zu};\n", c.valueCount, count);
+	printf("\treturn runCompiledODL(&program);\n}\n");
+
+	free(lines);
+	free(sources);
+	free(c.code.data);
+	free(c.values);
+	free(c.quoted);
+	for(size_t i=0; i<c.staticCount; i++){
+		freeODL(&c.statics[i].value);
+	}
+	free(c.statics);
+	freeListODL(c.tokens);
+	freeDictionaryODL(c.dictionary);
+	freeWordMapODL(&map);
+	return 0;
+}
+
+/* --serve. Requests and responses are a 4 byte big endian length followed by
+   that many bytes: the code to evaluate, and what the REPL would have printed
+   for it. The main thread owns the epoll loop and reads requests; once a
+   connection has a whole request it is handed to a worker, and it is only
+   watched again after the worker has answered, so each connection is owned
+   by one thread at a time and answered in order. Every worker boots its own
+   interpreter, and each request runs in an overlay on it that is thrown away
+   afterwards. */
+
+#define ODL_MAX_REQUEST (64<<20)
+
+typedef struct ODLConnection{
+	int fd;
+	char * data;
+	size_t length;
+	size_t alloc;
+	struct ODLConnection * next;
+} ODLConnection;
+
+typedef struct ODLServer{
+	int epoll;
+	char * lib;
+	size_t heapLimit;
+	size_t fuel;
+	size_t deadline;
+	size_t fiberSteps;
+	pthread_mutex_t lock;
+	pthread_cond_t ready;
+	ODLConnection * head;
+	ODLConnection * tail;
+} ODLServer;
+
+/* The size of the first request in the buffer, 0 if it has not all arrived
+   and SIZE_MAX if it is too big to accept. */
+size_t requestLengthODL(ODLConnection * connection){
+	if(connection->length<4){
+		return 0;
+	}
+	uint32_t length;
+	memcpy(&length, connection->data, 4);
+	length=ntohl(length);
+	if(length>ODL_MAX_REQUEST){
+		return SIZE_MAX;
+	}
+	return connection->length>=4+length ? 4+length : 0;
+}
+
+void closeConnectionODL(ODLConnection * connection){
+	close(connection->fd);
+	free(connection->data);
+	free(connection);
+}
+
+void watchConnectionODL(ODLServer * server, ODLConnection * connection, int op){
+	struct epoll_event event;
+	event.events=EPOLLIN | EPOLLONESHOT;
+	event.data.ptr=connection;
+	epoll_ctl(server->epoll, op, connection->fd, &event);
+}
+
+char writeAllODL(int fd, char * data, size_t size){
+	while(size>0){
+		ssize_t written=send(fd, data, size, MSG_NOSIGNAL);
+		if(written<0){
+			if(errno==EAGAIN || errno==EWOULDBLOCK){
+				struct pollfd wait={fd, POLLOUT, 0};
+				poll(&wait, 1, -1);
+				continue;
+			}
+			if(errno==EINTR){
+				continue;
+			}
+			return 0;
+		}
+		data+=written;
+		size-=written;
+	}
+	return 1;
+}
+
+char readAllODL(int fd, char * data, size_t size){
+	while(size>0){
+		ssize_t got=read(fd, data, size);
+		if(got<=0){
+			if(got<0 && errno==EINTR){
+				continue;
+			}
+			return 0;
+		}
+		data+=got;
+		size-=got;
+	}
+	return 1;
+}
+
+/* Evaluates the first request in the buffer and sends back the response.
+   Words first seen in the request are dropped from the map afterwards, as
+   nothing that could refer to them outlives the overlay, unless the request
+   imported a module. */
+char serveRequestODL(ODLConnection * connection, size_t frame, ODLDictionary * dictionary, ODLWordMap * map){
+	char * text=malloc(frame-4+1);
+	memcpy(text, connection->data+4, frame-4);
+	text[frame-4]=0;
+	connection->length-=frame;
+	memmove(connection->data, connection->data+frame, connection->length);
+
+	char * response=NULL;
+	size_t size=0;
+	FILE * stream=open_memstream(&response, &size);
+	outODL=stream;
+	size_t words=map->count;
+	ODLModule * modules=dictionary->modules;
+	ODLDictionary * overlay=overlayDictionary(dictionary);
+
+	evaluateODL(text, overlay, map);
+
+	freeFibersODL();
+	freeDictionaryODL(overlay);
+	if(dictionary->modules==modules){
+		for(size_t i=words; i<map->count; i++){
+			free(map->wordList[i]);
+		}
+		map->count=words;
+	}
+	outODL=stdout;
+	fclose(stream);
+	free(text);
+
+	uint32_t length=htonl(size);
+	char sent=writeAllODL(connection->fd, (char *)&length, 4) && writeAllODL(connection->fd, response, size);
+	free(response);
+	return sent;
+}
+
+void * serveWorkerODL(void * argument){
+	ODLServer * server=argument;
+	outODL=stdout;
+	memoryODL.limit=server->heapLimit;
+	budgetODL.fuel=server->fuel;
+	budgetODL.deadline=server->deadline;
+	schedulerODL.steps=server->fiberSteps;
+
+	/* The parser writes into the text it is given, so each worker parses
+	   its own copy of the stdlib. */
+	char * lib=strdup(server->lib);
+	ODLWordMap map;
+	ODLDictionary * dictionary=bootODL(&map, lib);
+	free(lib);
+
+	while(1){
+		pthread_mutex_lock(&server->lock);
+		while(server->head==NULL){
+			pthread_cond_wait(&server->ready, &server->lock);
+		}
+		ODLConnection * connection=server->head;
+		server->head=connection->next;
+		if(server->head==NULL){
+			server->tail=NULL;
+		}
+		pthread_mutex_unlock(&server->lock);
+
+		size_t frame;
+		char open=1;
+		while(open && (frame=requestLengthODL(connection))>0 && frame!=SIZE_MAX){
+			open=serveRequestODL(connection, frame, dictionary, &map);
+		}
+		if(!open || frame==SIZE_MAX){
+			closeConnectionODL(connection);
+			continue;
+		}
+		watchConnectionODL(server, connection, EPOLL_CTL_MOD);
+	}
+	return NULL;
+}
+
+/* Reads whatever has arrived on a connection, then either hands it to a
+   worker, waits for more, or closes it. */
+void readConnectionODL(ODLServer * server, ODLConnection * connection){
+	while(1){
+		if(connection->alloc-connection->length<4096){
+			connection->alloc*=2;
+			connection->data=realloc(connection->data, connection->alloc);
+		}
+		ssize_t got=read(connection->fd, connection->data+connection->length, connection->alloc-connection->length);
+		if(got>0){
+			connection->length+=got;
+			continue;
+		}
+		if(got<0 && errno==EINTR){
+			continue;
+		}
+		if(got<0 && (errno==EAGAIN || errno==EWOULDBLOCK)){
+			break;
+		}
+		closeConnectionODL(connection);
+		return;
+	}
+
+	size_t frame=requestLengthODL(connection);
+	if(frame==SIZE_MAX){
+		closeConnectionODL(connection);
+		return;
+	}
+	if(frame==0){
+		watchConnectionODL(server, connection, EPOLL_CTL_MOD);
+		return;
+	}
+	connection->next=NULL;
+	pthread_mutex_lock(&server->lock);
+	if(server->tail){
+		server->tail->next=connection;
+	}else{
+		server->head=connection;
+	}
+	server->tail=connection;
+	pthread_cond_signal(&server->ready);
+	pthread_mutex_unlock(&server->lock);
+}
+
+void serveODL(char * path, size_t workers, ODLServer * server){
+	int listener=socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0);
+	struct sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family=AF_UNIX;
+	if(strlen(path)>=sizeof(address.sun_path)){
+		printf("Socket path %s is too long\n", path);
+		exit(1);
+	}
+	strcpy(address.sun_path, path);
+	unlink(path);
+	if(listener<0 || bind(listener, (struct sockaddr *)&address, sizeof(address))<0 || listen(listener, 128)<0){
+		printf("Could not listen on %s: %s\n", path, strerror(errno));
+		exit(1);
+	}
+
+	server->epoll=epoll_create1(0);
+	struct epoll_event event;
+	event.events=EPOLLIN;
+	event.data.ptr=NULL;
+	epoll_ctl(server->epoll, EPOLL_CTL_ADD, listener, &event);
+
+	pthread_mutex_init(&server->lock, NULL);
+	pthread_cond_init(&server->ready, NULL);
+	server->head=NULL;
+	server->tail=NULL;
+	for(size_t i=0; i<workers; i++){
+		pthread_t thread;
+		pthread_create(&thread, NULL, &serveWorkerODL, server);
+		pthread_detach(thread);
+	}
+	printf("Serving on %s with %zu workers\n", path, workers);
+	fflush(stdout);
+
+	struct epoll_event events[64];
+	while(1){
+		int count=epoll_wait(server->epoll, events, 64, -1);
+		for(int i=0; i<count; i++){
+			if(events[i].data.ptr!=NULL){
+				readConnectionODL(server, events[i].data.ptr);
+				continue;
+			}
+			int fd;
+			while((fd=accept4(listener, NULL, NULL, SOCK_NONBLOCK))>=0){
+				ODLConnection * connection=malloc(sizeof(ODLConnection));
+				connection->fd=fd;
+				connection->alloc=8192;
+				connection->length=0;
+				connection->data=malloc(connection->alloc);
+				watchConnectionODL(server, connection, EPOLL_CTL_ADD);
+			}
+		}
+	}
+}
+
+/* --load. Sends the same request over a number of connections at once and
+   reports the latency percentiles and the overall rate. */
+
+typedef struct ODLLoad{
+	char * path;
+	char * code;
+	size_t requests;
+	double * latencies;
+	char * response;
+	size_t failed;
+} ODLLoad;
+
+void * loadWorkerODL(void * argument){
+	ODLLoad * load=argument;
+	int fd=socket(AF_UNIX, SOCK_STREAM, 0);
+	struct sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family=AF_UNIX;
+	strncpy(address.sun_path, load->path, sizeof(address.sun_path)-1);
+	if(fd<0 || connect(fd, (struct sockaddr *)&address, sizeof(address))<0){
+		load->failed=load->requests;
+		if(fd>=0){
+			close(fd);
+		}
+		return NULL;
+	}
+
+	size_t size=strlen(load->code);
+	uint32_t length=htonl(size);
+	for(size_t i=0; i<load->requests; i++){
+		struct timespec start, end;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		if(!writeAllODL(fd, (char *)&length, 4) || !writeAllODL(fd, load->code, size)){
+			load->failed=load->requests-i;
+			break;
+		}
+		uint32_t answer;
+		if(!readAllODL(fd, (char *)&answer, 4)){
+			load->failed=load->requests-i;
+			break;
+		}
+		answer=ntohl(answer);
+		char * response=malloc(answer+1);
+		if(!readAllODL(fd, response, answer)){
+			free(response);
+			load->failed=load->requests-i;
+			break;
+		}
+		response[answer]=0;
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		load->latencies[i]=(end.tv_sec-start.tv_sec)*1e3+(end.tv_nsec-start.tv_nsec)/1e6;
+		if(load->response==NULL){
+			load->response=response;
+		}else{
+			free(response);
+		}
+	}
+	close(fd);
+	return NULL;
+}
+
+int compareLatencyODL(const void * a, const void * b){
+	double x=*(const double *)a, y=*(const double *)b;
+	return (x>y)-(x<y);
+}
+
+int loadODL(char * path, char * code, size_t requests, size_t connections){
+	ODLLoad * loads=calloc(connections, sizeof(ODLLoad));
+	pthread_t * threads=malloc(connections*sizeof(pthread_t));
+	double * latencies=malloc(requests*sizeof(double));
+
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	size_t offset=0;
+	for(size_t i=0; i<connections; i++){
+		loads[i].path=path;
+		loads[i].code=code;
+		loads[i].requests=requests/connections+(i<requests%connections);
+		loads[i].latencies=latencies+offset;
+		offset+=loads[i].requests;
+		pthread_create(threads+i, NULL, &loadWorkerODL, loads+i);
+	}
+
+	size_t failed=0;
+	char * response=NULL;
+	for(size_t i=0; i<connections; i++){
+		pthread_join(threads[i], NULL);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double seconds=(end.tv_sec-start.tv_sec)+(end.tv_nsec-start.tv_nsec)/1e9;
+
+	/* Pack the latencies of the requests that completed together. */
+	size_t done=0;
+	for(size_t i=0; i<connections; i++){
+		size_t completed=loads[i].requests-loads[i].failed;
+		memmove(latencies+done, loads[i].latencies, completed*sizeof(double));
+		done+=completed;
+		failed+=loads[i].failed;
+		if(response==NULL){
+			response=loads[i].response;
+		}else{
+			free(loads[i].response);
+		}
+	}
+
+	if(response!=NULL){
+		printf("Response:\n%s", response);
+		free(response);
+	}
+	if(done>0){
+		qsort(latencies, done, sizeof(double), &compareLatencyODL);
+		printf("%zu requests over %zu connections in %.3fs: %.0f req/s, p50 %.3fms, p99 %.3fms\n",
+			done, connections, seconds, done/seconds, latencies[done/2], latencies[done*99/100]);
+	}
+	if(failed>0){
+		printf("%zu requests failed\n", failed);
+	}
+
+	free(latencies);
+	free(threads);
+	free(loads);
+	return failed>0;
+}
+
+#ifndef ODL_COMPILED
+int main(int argc, char ** argv){
+
+	outODL=stdout;
+	char * servePath=NULL;
+	char * compilePath=NULL;
+	char * loadPath=NULL;
+	char * loadCode=NULL;
+	size_t workers=sysconf(_SC_NPROCESSORS_ONLN);
+	size_t requests=10000;
+	size_t connections=16;
+	for(int i=1; i<argc; i++){
+		if(strcmp(argv[i], "--no-jit")==0){
+			jitEnabled=0;
+		}else if(strcmp(argv[i], "--no-fusion")==0){
+			fusionEnabled=0;
+		}else if(strcmp(argv[i], "--jit-threshold")==0 && i+1<argc){
+			jitThreshold=strtoul(argv[++i], NULL, 10);
+		}else if(strcmp(argv[i], "--heap-limit")==0 && i+1<argc){
+			memoryODL.limit=strtoull(argv[++i], NULL, 10);
+		}else if(strcmp(argv[i], "--fuel")==0 && i+1<argc){
+			budgetODL.fuel=strtoull(argv[++i], NULL, 10);
+		}else if(strcmp(argv[i], "--deadline")==0 && i+1<argc){
+			budgetODL.deadline=strtoull(argv[++i], NULL, 10);
+		}else if(strcmp(argv[i], "--fiber-steps")==0 && i+1<argc){
+			schedulerODL.steps=strtoull(argv[++i], NULL, 10);
+			if(schedulerODL.steps==0){
+				schedulerODL.steps=1;
+			}
+		}else if(strcmp(argv[i], "--compile")==0 && i+1<argc){
+			compilePath=argv[++i];
+		}else if(strcmp(argv[i], "--serve")==0 && i+1<argc){
+			servePath=argv[++i];
+		}else if(strcmp(argv[i], "--workers")==0 && i+1<argc){
+			workers=strtoull(argv[++i], NULL, 10);
+		}else if(strcmp(argv[i], "--load")==0 && i+2<argc){
+			loadPath=argv[++i];
+			loadCode=argv[++i];
+		}else if(strcmp(argv[i], "--requests")==0 && i+1<argc){
+			requests=strtoull(argv[++i], NULL, 10);
+		}else if(strcmp(argv[i], "--connections")==0 && i+1<argc){
+			connections=strtoull(argv[++i], NULL, 10);
+		}else{
+			printf("Unknown option %s\n", argv[i]);
+			exit(1);
+		}
+	}
+	if(workers==0){
+		workers=1;
+	}
+	if(connections==0){
+		connections=1;
+	}
+
+	if(loadPath!=NULL){
+		return loadODL(loadPath, loadCode, requests, connections);
+	}
+
+	char * lib=readStdlibODL();
+
+	if(compilePath!=NULL){
+		int status=compileODL(compilePath, lib);
+		free(lib);
+		return status;
+	}
+
+	if(servePath!=NULL){
+		ODLServer server;
+		server.lib=lib;
+		server.heapLimit=memoryODL.limit;
+		server.fuel=budgetODL.fuel;
+		server.deadline=budgetODL.deadline;
+		server.fiberSteps=schedulerODL.steps;
+		serveODL(servePath, workers, &server);
+	}
+
+	ODLWordMap map;
+	ODLDictionary * dictionary=bootODL(&map, lib);
+	free(lib);
+
+	char * buffer=NULL;
+	size_t bufsize=0;
+	while(1){
+		printf("> ");
+		if(getline(&buffer,&bufsize,stdin)<0){
+			break;
+		}
+
+		evaluateODL(buffer, dictionary, &map);
+	}
+	printf("\n");
+
+	free(buffer);
+	freeFibersODL();
+	freeDictionaryODL(dictionary);
+	freeWordMapODL(&map);
+	freeListPoolODL();
+	return 0;
+}
+#endif
@@ -0,0 +1,161 @@
+/* Concurrent define and lookup on a shared dictionary. Definer threads push
+   and pop definitions of the names they own, adding names as they go so the
+   table is copied and republished several times, while reader threads look
+   names up and copy their definitions without taking a lock. Each
+   definition is ( name step check ), check being name*31+step, so a reader
+   that saw a torn or freed definition finds it does not add up. At the end
+   every name has to have the definitions its owner left it. */
+#define ODL_COMPILED
+#include "odd.c"
+
+#define NAMES 4096
+#define DEFINERS 4
+#define READERS 4
+#define ROUNDS 20000
+#define DEEPEST 3
+
+ODLDictionary * shared;
+ODLWord names[NAMES];
+size_t depths[NAMES];
+ODLInt steps[NAMES];
+char definingDone=0;
+
+ODLData definition(ODLInt name, ODLInt step){
+	ODLData d;
+	d.type=ODL_LIST;
+	d.value.list=allocList(3);
+	ODLData item;
+	item.type=ODL_INT;
+	item.value.integer=name;
+	pushODL(d.value.list, item);
+	item.value.integer=step;
+	pushODL(d.value.list, item);
+	item.value.integer=name*31+step;
+	pushODL(d.value.list, item);
+	return d;
+}
+
+char addsUp(ODLData * d, ODLInt name){
+	if(d->type!=ODL_LIST || d->value.list->top-d->value.list->bottom!=3){
+		return 0;
+	}
+	ODLData * items=d->value.list->bottom;
+	return items[0].type==ODL_INT && items[0].value.integer==name
+		&& items[2].value.integer==name*31+items[1].value.integer;
+}
+
+void * defineWorker(void * arg){
+	outODL=stdout;
+	size_t owner=(size_t)arg;
+	uint64_t seed=owner+1;
+	for(ODLInt step=0; step<ROUNDS; step++){
+		seed=seed*6364136223846793005ULL+1442695040888963407ULL;
+		/* Names come into use a few at a time, so the table keeps growing
+		   while the readers are at it. */
+		size_t used=step/16+1<NAMES/DEFINERS ? step/16+1 : NAMES/DEFINERS;
+		size_t name=(seed>>33)%used*DEFINERS+owner;
+		if(depths[name]<DEEPEST && (depths[name]==0 || (seed>>20)%3!=0)){
+			pushToDictionary(shared, names[name], definition(name, step));
+			depths[name]++;
+			steps[name]=step;
+		}else{
+			popFromDictionary(shared, names[name]);
+			depths[name]--;
+			steps[name]=-1;
+		}
+	}
+	freeListPoolODL();
+	return NULL;
+}
+
+typedef struct Reader {
+	size_t index;
+	size_t found;
+	size_t bad;
+} Reader;
+
+void * lookupWorker(void * arg){
+	outODL=stdout;
+	Reader * reader=arg;
+	uint64_t seed=reader->index+100;
+	while(!__atomic_load_n(&definingDone, __ATOMIC_ACQUIRE)){
+		seed=seed*6364136223846793005ULL+1442695040888963407ULL;
+		size_t name=(seed>>33)%NAMES;
+		ODLData d;
+		d.type=ODL_INT;
+		pinODL();
+		ODLDefStack * entry=findEntryInDictionary(shared, names[name]);
+		if(entry!=NULL){
+			ODLList * code=definitionsODL(entry);
+			if(code->top>code->bottom){
+				d=copyODL(*(code->top-1));
+			}
+		}
+		unpinODL();
+		if(d.type!=ODL_INT){
+			reader->found++;
+			if(!addsUp(&d, name)){
+				reader->bad++;
+			}
+			freeODL(&d);
+		}
+	}
+	freeListPoolODL();
+	return NULL;
+}
+
+int main(){
+	outODL=stdout;
+	ODLWordMap map;
+	ODLDictionary * root=newDictionaryODL(&map);
+	for(size_t i=0; i<NAMES; i++){
+		char name[32];
+		sprintf(name, "stress%zu", i);
+		names[i]=findInWordMap(name, &map);
+	}
+	shared=overlayDictionary(root);
+	shareDictionaryODL(shared);
+
+	pthread_t definers[DEFINERS];
+	pthread_t readers[READERS];
+	Reader reading[READERS];
+	for(size_t i=0; i<READERS; i++){
+		reading[i].index=i;
+		reading[i].found=0;
+		reading[i].bad=0;
+		pthread_create(readers+i, NULL, &lookupWorker, reading+i);
+	}
+	for(size_t i=0; i<DEFINERS; i++){
+		pthread_create(definers+i, NULL, &defineWorker, (void *)i);
+	}
+	for(size_t i=0; i<DEFINERS; i++){
+		pthread_join(definers[i], NULL);
+	}
+	__atomic_store_n(&definingDone, 1, __ATOMIC_RELEASE);
+	size_t found=0;
+	size_t bad=0;
+	for(size_t i=0; i<READERS; i++){
+		pthread_join(readers[i], NULL);
+		found+=reading[i].found;
+		bad+=reading[i].bad;
+	}
+
+	size_t wrong=0;
+	for(size_t i=0; i<NAMES; i++){
+		ODLDefStack * entry=lookupEntryODL(shared, names[i]);
+		size_t depth=entry==NULL ? 0 : entry->code->top-entry->code->bottom;
+		if(depth!=depths[i] || (depth>0 && (!addsUp(entry->code->top-1, i)
+			|| (steps[i]>=0 && entry->code->top[-1].value.list->bottom[1].value.integer!=steps[i])))){
+			wrong++;
+		}
+	}
+	if(bad>0 || wrong>0 || found==0){
+		printf("%zu of %zu definitions read did not add up, %zu names left wrong\n", bad, found, wrong);
+	}
+
+	freeDictionaryODL(shared);
+	freeDictionaryODL(root);
+	freeWordMapODL(&map);
+	freeListPoolODL();
+	return bad>0 || wrong>0 || found==0;
+}